@@ -1,10 +1,18 @@
 #include <iostream>
 #include <string>
 #include <cstdlib>
-#include <ctime>
-#include <sstream>
-#include <map>
 #include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string_view>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <climits>
 
 #ifdef _WIN32
     #include <winsock2.h>
@@ -15,259 +23,258 @@
     #include <sys/socket.h>
     #include <netinet/in.h>
     #include <unistd.h>
+    #include <signal.h>
     #define SOCKET int
     #define INVALID_SOCKET -1
     #define SOCKET_ERROR -1
     #define closesocket close
 #endif
 
-using namespace std;
+#include "http_parser.h"
+#include "json.h"
+#include "http_response.h"
+#include "rng.h"
+#include "session_store.h"
+#include "logger.h"
+#include "metrics.h"
+#include "games.h"
+#include "timer_wheel.h"
+#include "push_hub.h"
+#include "leaderboard.h"
+#include "journal.h"
+#include "static_files.h"
+#include "uring.h"
+#include "rate_limiter.h"
 
-// ================= JSON Helper Functions =================
-string createJsonResponse(const map<string, string>& data) {
-    stringstream json;
-    json << "{";
-    bool first = true;
-    for (const auto& pair : data) {
-        if (!first) json << ",";
-        json << "\"" << pair.first << "\":\"" << pair.second << "\"";
-        first = false;
-    }
-    json << "}";
-    return json.str();
-}
+#ifdef __linux__
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/uio.h>
+    #include <sys/resource.h>
+    #include <fcntl.h>
+    #include <errno.h>
+    #define SQUID_HAVE_EPOLL 1
+#endif
 
-string parseJsonField(const string& json, const string& field) {
-    size_t pos = json.find("\"" + field + "\"");
-    if (pos == string::npos) return "";
-    
-    pos = json.find(":", pos);
-    if (pos == string::npos) return "";
-    
-    pos = json.find("\"", pos);
-    if (pos == string::npos) return "";
-    
-    size_t end = json.find("\"", pos + 1);
-    if (end == string::npos) return "";
-    
-    return json.substr(pos + 1, end - pos - 1);
-}
+using namespace std;
 
-int parseJsonInt(const string& json, const string& field) {
-    size_t pos = json.find("\"" + field + "\"");
-    if (pos == string::npos) return 0;
-    
-    pos = json.find(":", pos);
-    if (pos == string::npos) return 0;
-    
-    // Skip whitespace and quotes
-    while (pos < json.length() && (json[pos] == ':' || json[pos] == ' ' || json[pos] == '"')) pos++;
-    
-    string numStr;
-    while (pos < json.length() && (isdigit(json[pos]) || json[pos] == '-')) {
-        numStr += json[pos++];
-    }
-    
-    return numStr.empty() ? 0 : atoi(numStr.c_str());
-}
+// ================= Timers =================
+// Every event loop owns a timer wheel. Room timers carry the room's key and
+// record id and look the room up again when they fire, so a timer for a room
+// that was evicted or replaced in the meantime does nothing.
+struct LoopTimer {
+    enum Kind : uint8_t { IDLE_CONNECTION, ROOM_TTL, LIGHT_CHANGE, RUN_DEADLINE };
+    Kind kind = IDLE_CONNECTION;
+    uint16_t epoch = 0;  // RUN_DEADLINE: the run it was armed for
+    uint32_t roomId = 0;
+    uint64_t key = 0;    // room or run key
+    int fd = -1;         // IDLE_CONNECTION
 
-// ================= Game Logic Classes =================
-class RedLightGreenLightGame {
-public:
-    static string processAction(const string& playerName, const string& action, int position) {
-        // Generate light (50/50 chance)
-        bool isGreen = (rand() % 100) < 50;
-        string light = isGreen ? "GREEN" : "RED";
-        
-        bool survived = true;
-        string message;
-        int newPosition = position;
-        
-        // Player action: "move" or "stay"
-        if (action == "move") {
-            if (light == "GREEN") {
-                // GREEN light - safe to move forward
-                newPosition = position + 1;
-                message = "Ran forward safely!";
-            } else {
-                // RED light and player moved - instant death, no chance
-                survived = false;
-                message = "BANG! Moved during RED light! Shot by the doll!";
-                newPosition = position;  // Don't advance if dead
-            }
-        } else {
-            // Player stayed
-            if (light == "GREEN") {
-                message = "Stayed still during GREEN light. No progress.";
-            } else {
-                message = "Stayed frozen during RED light. Safe!";
-            }
-        }
-        
-        map<string, string> response;
-        response["light"] = light;
-        response["survived"] = survived ? "true" : "false";
-        response["position"] = to_string(newPosition);
-        response["message"] = message;
-        
-        return createJsonResponse(response);
+    static LoopTimer room(Kind kind, uint64_t key, uint32_t roomId, uint16_t epoch = 0) {
+        LoopTimer t;
+        t.kind = kind;
+        t.key = key;
+        t.roomId = roomId;
+        t.epoch = epoch;
+        return t;
+    }
+    static LoopTimer connection(int fd) {
+        LoopTimer t;
+        t.fd = fd;
+        return t;
     }
 };
+using LoopTimers = TimerWheel<LoopTimer>;
 
-class GlassBridgeGame {
-private:
-    // Track broken panels globally - shared across all players
-    static bool brokenPanels[18][2]; // [step][0=left, 1=right]
-    static bool bridgeInitialized;
+// ================= Routing =================
+// Paths and methods are decoded through compile-time perfect hashes: one
+// hash, one slot and one comparison instead of a chain of string compares.
+enum class Route : uint8_t { Unknown, RedLight, GlassBridge, GlassBridgeReset, TugOfWar, Batch, Events, Metrics, Leaderboard };
+enum class Method : uint8_t { Other, Get, Head, Post, Options };
+
+static constexpr Keyword<Route> ROUTE_WORDS[] = {
+    {"/redlight", Route::RedLight}, {"/glassbridge", Route::GlassBridge}, {"/glassbridge/reset", Route::GlassBridgeReset},
+    {"/tugofwar", Route::TugOfWar}, {"/batch", Route::Batch},             {"/events", Route::Events},
+    {"/metrics", Route::Metrics},   {"/leaderboard", Route::Leaderboard}};
+static constexpr auto ROUTES = makeKeywordTable(ROUTE_WORDS, Route::Unknown);
+static_assert(ROUTES.perfect, "no collision-free seed for the routes");
+
+static constexpr Keyword<Method> METHOD_WORDS[] = {
+    {"GET", Method::Get}, {"HEAD", Method::Head}, {"POST", Method::Post}, {"OPTIONS", Method::Options}};
+static constexpr auto METHODS = makeKeywordTable(METHOD_WORDS, Method::Other);
+static_assert(METHODS.perfect, "no collision-free seed for the methods");
+
+// The query string, if any, does not take part in routing
+static Route routeFor(string_view target) { return ROUTES.lookup(targetPath(target)); }
+
+// ================= HTTP Server =================
+#ifdef SQUID_HAVE_EPOLL
+// Per-connection state for the epoll loop. recv() fills `in` in place and
+// `parser` picks up where the previous read left off; responses to pipelined
+// requests are appended to `out` in request order and flushed from outSent.
+struct Connection {
+    SOCKET fd = INVALID_SOCKET;
+    uint32_t peer = 0;            // client IPv4 address, for the rate limiter
+    ByteBuffer in;
+    // When the oldest request in `in` can have arrived (Worker::noteWakeup).
+    // Requests held back behind unsent output keep the time they were read.
+    chrono::steady_clock::time_point queuedSince;
+    bool heldBack = false;
+    bool readPaused = false;      // `in` is full; the socket is read again once output drains
+    HttpRequestParser parser;
+    string out;
+    size_t outSent = 0;
+    bool closeAfterWrite = false; // Connection: close, or HTTP/1.0 without keep-alive
+    bool peerClosed = false;      // client shut down its side after sending
+    chrono::steady_clock::time_point lastActive;
+    TimerId idleTimer = 0;        // fires keepAliveTimeoutSec after the last activity
     
-public:
-    static string processChoice(const string& playerName, const string& choice, int step) {
-        // Initialize bridge if first use
-        if (!bridgeInitialized) {
-            for (int i = 0; i < 18; i++) {
-                brokenPanels[i][0] = false;
-                brokenPanels[i][1] = false;
-            }
-            bridgeInitialized = true;
-        }
-        
-        bool choseLeft = (choice == "left");
-        int panelIndex = choseLeft ? 0 : 1;
-        
-        // Check if panel is already known to be broken
-        if (brokenPanels[step][panelIndex]) {
-            map<string, string> response;
-            response["survived"] = "false";
-            response["correctChoice"] = choseLeft ? "right" : "left";
-            response["message"] = "That panel is already broken! You fall!";
-            return createJsonResponse(response);
-        }
-        
-        // Check if the other panel is broken (making this one safe)
-        int otherPanel = 1 - panelIndex;
-        if (brokenPanels[step][otherPanel]) {
-            map<string, string> response;
-            response["survived"] = "true";
-            response["correctChoice"] = choice;
-            response["message"] = "Only safe option! You advance!";
-            return createJsonResponse(response);
-        }
-        
-        // Random 50/50 chance - one is tempered, one is normal
-        // Use consistent seed for same step to maintain bridge integrity
-        srand(time(0) + step * 7 + panelIndex);
-        bool isSafe = (rand() % 10 < 7);
-        srand(time(0)); // Reset
-        
-        map<string, string> response;
-        
-        if (isSafe) {
-            response["survived"] = "true";
-            response["correctChoice"] = choice;
-            response["message"] = "Tempered glass! Safe step!";
-        } else {
-            // Mark this panel as broken for future players
-            brokenPanels[step][panelIndex] = true;
-            response["survived"] = "false";
-            response["correctChoice"] = choseLeft ? "right" : "left";
-            response["message"] = "Normal glass! It shatters! You fall!";
-        }
-        
-        return createJsonResponse(response);
-    }
+    // Event stream (GET /events). After its headers the connection only
+    // carries pushed frames, queued by reference and sent in order.
+    bool streaming = false;
+    uint64_t streamRoom = 0;
+    deque<PushFrame> frames;
+    size_t frameSent = 0;         // bytes of frames.front() already sent
+    size_t framesBytes = 0;       // unsent bytes across frames
+    bool flushQueued = false;     // listed for the flush at the end of deliverPushes
+    
+    // Body of a static file response, sent with sendfile once `out` is drained
+    FileSend file;
     
-    static void resetBridge() {
-        bridgeInitialized = false;
+#ifdef SQUID_HAVE_URING
+    // io_uring loop: operations the kernel still holds for this socket. The
+    // buffers they point into (out, frames, sendMsg) are left alone until
+    // they complete, and the socket is only closed once inflight is 0.
+    int inflight = 0;
+    bool recvArmed = false;       // the multishot recv has not posted its last completion
+    bool sendInFlight = false;
+    bool closing = false;
+    iovec sendIov[16];
+    msghdr sendMsg;
+#endif
+    
+    // Buffers larger than this are released instead of carried into a
+    // recycled connection
+    static const size_t KEEP_BUFFER_BYTES = 64 * 1024;
+    
+    // Back to the state of a newly accepted connection, keeping the buffers'
+    // allocations (see Worker::spareConnections)
+    void recycle() {
+        fd = INVALID_SOCKET;
+        if (in.capacity() > KEEP_BUFFER_BYTES) in = ByteBuffer();
+        else in.clear();
+        parser.reset();
+        if (out.capacity() > KEEP_BUFFER_BYTES) string().swap(out);
+        else out.clear();
+        outSent = 0;
+        closeAfterWrite = false;
+        peerClosed = false;
+        heldBack = false;
+        readPaused = false;
+        idleTimer = 0;
+        streaming = false;
+        streamRoom = 0;
+        frames.clear();
+        frameSent = 0;
+        framesBytes = 0;
+        flushQueued = false;
+        file = FileSend();
+#ifdef SQUID_HAVE_URING
+        inflight = 0;
+        recvArmed = false;
+        sendInFlight = false;
+        closing = false;
+#endif
     }
 };
+#endif
 
-// Static member initialization
-bool GlassBridgeGame::brokenPanels[18][2];
-bool GlassBridgeGame::bridgeInitialized = false;
+// Requests larger than this are answered with 413 instead of buffered forever
+const size_t MAX_REQUEST_SIZE = 64 * 1024;
 
-class TugOfWarGame {
-public:
-    static string processPull(const string& playerName, int currentStrength, int turn, int opponentStrength, const string& strategy) {
-        // Strategy-based Tug of War (more realistic)
-        int pullStrength = 0;
-        string message;
-        int staminaCost = 0;
-        
-        // Decode strategy: 1=hard pull, 2=steady, 3=three-steps, 4=hold
-        int strategyNum = 2; // default
-        if (strategy == "hard" || strategy == "1") {
-            strategyNum = 1;
-        } else if (strategy == "steady" || strategy == "2") {
-            strategyNum = 2;
-        } else if (strategy == "three-steps" || strategy == "3") {
-            strategyNum = 3;
-        } else if (strategy == "hold" || strategy == "4") {
-            strategyNum = 4;
-        }
-        
-        switch(strategyNum) {
-            case 1: // Hard pull
-                pullStrength = rand() % 6 + 4; // 4-9
-                staminaCost = 8;
-                message = "Pulled hard!";
-                break;
-            case 2: // Steady
-                pullStrength = rand() % 4 + 3; // 3-6
-                staminaCost = 3;
-                message = "Steady pull!";
-                break;
-            case 3: // Three-steps technique
-                if (rand() % 100 < 60) { // 60% success
-                    pullStrength = rand() % 8 + 6; // 6-13
-                    message = "Three-steps worked! Big advantage!";
-                } else {
-                    pullStrength = rand() % 3 + 1; // 1-3
-                    message = "Three-steps failed! Bad timing!";
-                }
-                staminaCost = 5;
-                break;
-            case 4: // Hold position
-                pullStrength = rand() % 2 + 1; // 1-2
-                staminaCost = -5; // Regain stamina
-                message = "Held position, regained stamina!";
-                break;
-            default:
-                pullStrength = 3;
-                staminaCost = 3;
-                message = "Keep pulling!";
-        }
-        
-        int newStrength = currentStrength + pullStrength;
-        
-        // Determine if game is over (10 rounds or position extreme)
-        bool survived = false;
-        if (turn >= 10) {
-            survived = (newStrength >= opponentStrength);
-            message = survived ? "You won!" : "You lost!";
-        } else {
-            message += " Current advantage: " + to_string(newStrength - opponentStrength);
-        }
-        
-        map<string, string> response;
-        response["playerStrength"] = to_string(newStrength);
-        response["opponentStrength"] = to_string(opponentStrength);
-        response["survived"] = survived ? "true" : "false";
-        response["message"] = message;
-        response["pullStrength"] = to_string(pullStrength);
-        response["staminaCost"] = to_string(staminaCost);
-        
-        return createJsonResponse(response);
+// Stop handling pipelined requests while this much output is still unsent
+const size_t MAX_PENDING_OUTPUT = 256 * 1024;
+
+// Stop reading from a client while this much of its input is waiting on
+// that output, so one that never reads its responses is held by TCP flow
+// control rather than buffered here
+const size_t MAX_PENDING_INPUT = 256 * 1024;
+
+// How sockets are driven, chosen at startup (--io). Auto takes io_uring where
+// the kernel supports it, then epoll; blocking serves one client at a time
+// and is all that is left where neither exists.
+enum class IoBackend : uint8_t { Auto, Uring, Epoll, Blocking };
+
+static const char* ioBackendName(IoBackend io) {
+    switch (io) {
+        case IoBackend::Uring: return "io_uring";
+        case IoBackend::Epoll: return "epoll";
+        case IoBackend::Blocking: return "blocking";
+        default: return "auto";
     }
+}
+
+struct ServerConfig {
+    int port = 8080;
+    int workers = 0; // event-loop threads; 0 = one per hardware thread
+    IoBackend io = IoBackend::Auto;
+    int keepAliveTimeoutSec = 15; // idle keep-alive connections are closed after this
+    size_t maxRooms = 200000;     // game rooms held in memory at once
+    int roomTtlSec = 1800;        // rooms untouched this long are evicted
+#ifdef SQUID_HAVE_MMAP
+    string resultsPath = "results.log"; // finished runs are appended here; empty = not recorded
+#else
+    string resultsPath; // the results log needs mmap
+#endif
+    string journalPath;           // room journal for replay; empty = off
+    int snapshotSec = 60;         // session snapshot next to the journal this often; 0 = never
+    string staticRoot = "../frontend"; // frontend files served on GET; empty = none
+    
+    // Admission control (see SimpleHttpServer::refuse)
+    int backlog = SOMAXCONN;      // pending connections the kernel queues per listener
+    int maxConnections = 0;       // open client connections; 0 = what the fd limit allows
+    uint32_t rateLimit = 0;       // requests per second per client address; 0 = unlimited
+    uint32_t rateBurst = 0;       // requests a client may send at once, up to RateLimiter::MAX_BURST; 0 = twice rateLimit
+    int shedAfterMs = 50;         // requests that waited longer get 503; 0 = never shed
 };
 
-// ================= HTTP Server =================
+// Sent to a connection accepted past --max-connections, before closing it
+static const char CONNECTION_LIMIT_RESPONSE[] =
+    "HTTP/1.1 503 Service Unavailable\r\nContent-Type: application/json\r\nRetry-After: 1\r\n"
+    "Connection: close\r\nContent-Length: 32\r\n\r\n{\"error\":\"Too many connections\"}";
+
 class SimpleHttpServer {
 private:
+    ServerConfig config;
     SOCKET serverSocket;
     int port;
+    SessionStore sessions;
+    StaticFiles staticFiles;
+    RateLimiter rateLimiter;
+    chrono::steady_clock::time_point started = chrono::steady_clock::now();
+#ifdef SQUID_HAVE_EPOLL
+    class Worker;
+    vector<unique_ptr<Worker>> workers;
+    PushHub pushHub;
+#endif
     
 public:
-    SimpleHttpServer(int p = 8080) : port(p), serverSocket(INVALID_SOCKET) {}
+    SimpleHttpServer(const ServerConfig& cfg = ServerConfig())
+        : config(cfg), serverSocket(INVALID_SOCKET), port(cfg.port),
+          sessions(cfg.maxRooms, (uint32_t)cfg.roomTtlSec),
+          rateLimiter(cfg.rateLimit, cfg.rateBurst ? cfg.rateBurst : min(cfg.rateLimit * 2, RateLimiter::MAX_BURST)) {
+        if (config.workers <= 0) {
+            config.workers = max(1u, thread::hardware_concurrency());
+        }
+#ifdef SQUID_HAVE_EPOLL
+        // Past the fd limit accept() fails with EMFILE and the listener stays
+        // readable, so stop short of it and keep some fds for files and logs
+        rlimit files;
+        if (config.maxConnections <= 0 && getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur != RLIM_INFINITY) {
+            config.maxConnections = (int)max<rlim_t>(files.rlim_cur > 64 ? files.rlim_cur - 64 : 1, 1);
+        }
+#endif
+    }
     
     bool initialize() {
 #ifdef _WIN32
@@ -278,18 +285,114 @@ public:
         }
 #endif
         
-        serverSocket = socket(AF_INET, SOCK_STREAM, 0);
-        if (serverSocket == INVALID_SOCKET) {
-            cerr << "Socket creation failed" << endl;
+        if (!config.journalPath.empty()) {
+            string error;
+            if (!Journal::instance().open(config.journalPath, sessions, config.snapshotSec, error)) {
+                cerr << "Cannot open journal " << error << endl;
+                return false;
+            }
+        }
+        
+        // Serving the frontend is optional; the API works without it
+        if (!config.staticRoot.empty()) {
+            string error;
+            if (staticFiles.load(config.staticRoot, error)) {
+                cout << "Serving " << staticFiles.size() << " frontend files from " << config.staticRoot << " ("
+                     << staticFiles.bytesInMemory() / 1024 << " KB in memory)" << endl;
+            } else {
+                cout << "Not serving frontend files: " << error << endl;
+            }
+        }
+        
+        if (!chooseIoBackend()) return false;
+        
+#ifdef SQUID_HAVE_EPOLL
+        // Every worker binds its own listener with SO_REUSEPORT so the kernel
+        // spreads incoming connections across cores. If the kernel refuses,
+        // all workers share one listener instead.
+        bool reusePort = true;
+        for (int i = 0; config.io != IoBackend::Blocking && i < config.workers; i++) {
+            SOCKET listener = reusePort ? createListenSocket(true) : serverSocket;
+            if (listener == INVALID_SOCKET && i == 0) {
+                reusePort = false;
+                listener = createListenSocket(false);
+            }
+            if (listener == INVALID_SOCKET) return false;
+            if (i == 0) serverSocket = listener;
+            workers.emplace_back(new Worker(*this, listener, listener != serverSocket || i == 0, i));
+        }
+#endif
+        if (config.io == IoBackend::Blocking) {
+            serverSocket = createListenSocket(false);
+            if (serverSocket == INVALID_SOCKET) return false;
+        }
+        
+        cout << "==================================" << endl;
+        cout << "  SQUID GAME Backend Server" << endl;
+        cout << "  Running on port: " << port << endl;
+        cout << "  I/O: " << ioBackendName(config.io) << endl;
+        if (config.io != IoBackend::Blocking) {
+            cout << "  Worker threads: " << config.workers << endl;
+            if (config.maxConnections > 0) cout << "  Connection limit: " << config.maxConnections << endl;
+        }
+        if (rateLimiter.enabled()) cout << "  Rate limit: " << config.rateLimit << " requests/s per client" << endl;
+        cout << "==================================" << endl;
+        
+        return true;
+    }
+    
+    // Resolve --io against what this build and kernel offer. Auto falls back
+    // quietly; asking for a backend that is not available is an error.
+    bool chooseIoBackend() {
+#ifdef SQUID_HAVE_EPOLL
+        if (config.io == IoBackend::Auto || config.io == IoBackend::Uring) {
+            string error = "not built with io_uring";
+#ifdef SQUID_HAVE_URING
+            if (Uring::probe(error)) {
+                config.io = IoBackend::Uring;
+                return true;
+            }
+#endif
+            if (config.io == IoBackend::Uring) {
+                cerr << "Cannot use io_uring: " << error << endl;
+                return false;
+            }
+            config.io = IoBackend::Epoll;
+        }
+#else
+        if (config.io == IoBackend::Uring || config.io == IoBackend::Epoll) {
+            cerr << "Cannot use " << ioBackendName(config.io) << " on this platform" << endl;
             return false;
         }
+        config.io = IoBackend::Blocking;
+#endif
+        return true;
+    }
+    
+    SOCKET createListenSocket(bool reusePort) {
+        SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener == INVALID_SOCKET) {
+            cerr << "Socket creation failed" << endl;
+            return INVALID_SOCKET;
+        }
         
         // Set socket options to reuse address
         int opt = 1;
 #ifdef _WIN32
-        setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
+#else
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+#endif
+#ifdef SO_REUSEPORT
+        if (reusePort && setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) != 0) {
+            closesocket(listener);
+            return INVALID_SOCKET;
+        }
 #else
-        setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        if (reusePort) {
+            closesocket(listener);
+            return INVALID_SOCKET;
+        }
 #endif
         
         sockaddr_in serverAddr;
@@ -297,118 +400,1479 @@ public:
         serverAddr.sin_port = htons(port);
         serverAddr.sin_addr.s_addr = INADDR_ANY;
         
-        if (bind(serverSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
+        if (bind(listener, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
             cerr << "Bind failed" << endl;
-            closesocket(serverSocket);
-            return false;
+            closesocket(listener);
+            return INVALID_SOCKET;
         }
         
-        if (listen(serverSocket, 10) == SOCKET_ERROR) {
+        if (listen(listener, config.backlog) == SOCKET_ERROR) {
             cerr << "Listen failed" << endl;
-            closesocket(serverSocket);
-            return false;
+            closesocket(listener);
+            return INVALID_SOCKET;
         }
         
-        cout << "==================================" << endl;
-        cout << "  SQUID GAME Backend Server" << endl;
-        cout << "  Running on port: " << port << endl;
-        cout << "==================================" << endl;
-        
-        return true;
+        return listener;
     }
     
     void run() {
+#ifdef SQUID_HAVE_EPOLL
+        if (config.io == IoBackend::Blocking) {
+            runBlocking();
+            return;
+        }
+        // Worker 0 runs on the calling thread, the rest get their own
+        vector<thread> threads;
+        for (size_t i = 1; i < workers.size(); i++) {
+            threads.emplace_back(&Worker::run, workers[i].get());
+        }
+        workers[0]->run();
+        for (auto& t : threads) t.join();
+#else
+        runBlocking();
+#endif
+    }
+    
+    // One client at a time: accept, answer, close. Used where epoll is
+    // unavailable, or with --io=blocking.
+    void runBlocking() {
+        LoopTimers timers;
+        ByteBuffer buffer; // reused by every client, like a recycled Connection
+        string out;
         while (true) {
             sockaddr_in clientAddr;
             socklen_t clientLen = sizeof(clientAddr);
             
             SOCKET clientSocket = accept(serverSocket, (sockaddr*)&clientAddr, &clientLen);
             if (clientSocket == INVALID_SOCKET) {
-                cerr << "Accept failed" << endl;
+                Metrics::local().acceptErrors.add();
+                SQUID_LOG(LogLevel::Error, "accept failed");
                 continue;
             }
             
-            handleClient(clientSocket);
+            Metrics::local().connectionsOpened.add();
+            // Timers only run between clients here, but always before the next
+            // request is judged, so deadlines still hold
+            timers.advance(chrono::steady_clock::now(), [&](const LoopTimer& timer) { onRoomTimer(timers, timer); });
+            handleClient(clientSocket, clientAddr.sin_addr.s_addr, timers, buffer, out);
             closesocket(clientSocket);
+            Metrics::local().connectionsClosed.add();
         }
     }
     
-    void handleClient(SOCKET clientSocket) {
-        char buffer[4096] = {0};
-        int bytesRead = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
+    void handleClient(SOCKET clientSocket, uint32_t peer, LoopTimers& timers, ByteBuffer& buffer, string& out) {
+        buffer.clear();
+        out.clear();
+        HttpRequestParser parser(MAX_REQUEST_SIZE);
+        HttpRequest request;
+        HttpRequestParser::Status status = HttpRequestParser::Incomplete;
         
-        if (bytesRead <= 0) return;
-        
-        string request(buffer);
-        string response = processRequest(request);
+        // Keep reading until the headers and the whole body have arrived
+        while (status == HttpRequestParser::Incomplete) {
+            char* dest = buffer.writePtr(4096);
+            int bytesRead = recv(clientSocket, dest, (int)buffer.writableSize(), 0);
+            if (bytesRead <= 0) return;
+            Metrics::local().bytesIn.add(bytesRead);
+            buffer.commit(bytesRead);
+            status = parser.parse(buffer.readable(), request);
+        }
         
-        // Send HTTP response with CORS headers
-        stringstream httpResponse;
-        httpResponse << "HTTP/1.1 200 OK\r\n";
-        httpResponse << "Content-Type: application/json\r\n";
-        httpResponse << "Access-Control-Allow-Origin: *\r\n";
-        httpResponse << "Access-Control-Allow-Methods: POST, GET, OPTIONS\r\n";
-        httpResponse << "Access-Control-Allow-Headers: Content-Type\r\n";
-        httpResponse << "Content-Length: " << response.length() << "\r\n";
-        httpResponse << "\r\n";
-        httpResponse << response;
+        HttpResponseWriter response(out, false, config.keepAliveTimeoutSec);
+        if (status == HttpRequestParser::Complete) {
+            // Requests do not queue here beyond the kernel backlog, so only the rate applies
+            if (!refuse(request, response, peer, chrono::steady_clock::now())) processRequest(request, response, timers);
+        } else {
+            Metrics::local().parseFailures.add();
+            writeErrorResponse(status, response);
+        }
+        int sent = send(clientSocket, out.data(), (int)out.size(), 0);
+        if (sent > 0) Metrics::local().bytesOut.add(sent);
+    }
+    
+    // Admission control, before any handler runs. A client over its rate
+    // gets 429, and a request that has waited more than --shed-after-ms since
+    // it reached the event loop gets 503. Both carry Retry-After and leave the
+    // connection open. Under overload, answering some requests this cheaply
+    // keeps the wait of the rest bounded instead of letting every request wait
+    // longer. /metrics is always answered. Returns true if it wrote a refusal.
+    bool refuse(const HttpRequest& request, HttpResponseWriter& response, uint32_t peer,
+                chrono::steady_clock::time_point queuedSince) {
+        if (!rateLimiter.enabled() && config.shedAfterMs <= 0) return false;
+        if (routeFor(request.path) == Route::Metrics) return false;
+        auto now = chrono::steady_clock::now();
         
-        string fullResponse = httpResponse.str();
-        send(clientSocket, fullResponse.c_str(), fullResponse.length(), 0);
+        uint32_t retryAfter = 1;
+        uint32_t nowMs = (uint32_t)chrono::duration_cast<chrono::milliseconds>(now - started).count();
+        if (!rateLimiter.allow(peer, nowMs, retryAfter)) {
+            Metrics::local().rateLimited.add();
+            writeRefusal(response, request.path, 429, retryAfter, "Too many requests");
+            return true;
+        }
+        if (config.shedAfterMs > 0 && now - queuedSince > chrono::milliseconds(config.shedAfterMs)) {
+            Metrics::local().requestsShed.add();
+            writeRefusal(response, request.path, 503, 1, "Server overloaded");
+            return true;
+        }
+        return false;
     }
     
-    string processRequest(const string& request) {
-        // Handle OPTIONS request for CORS
-        if (request.find("OPTIONS") == 0) {
-            return "";
+    static void writeRefusal(HttpResponseWriter& response, string_view path, int status, uint32_t retryAfterSec,
+                             string_view message) {
+        char header[32];
+        int n = snprintf(header, sizeof(header), "Retry-After: %u\r\n", retryAfterSec);
+        writeJsonError(response.begin(status, "application/json", string_view(header, (size_t)n)), message);
+        response.end();
+        SQUID_LOG(LogLevel::Info, "refused", path, status);
+    }
+    
+    // Response for a request the parser rejected; the connection is closed after it
+    void writeErrorResponse(HttpRequestParser::Status status, HttpResponseWriter& response) {
+        bool tooLarge = (status == HttpRequestParser::TooLarge);
+        writeJsonError(response.begin(tooLarge ? 413 : 400), tooLarge ? "Request too large" : "Bad request");
+        response.end();
+    }
+    
+#ifdef SQUID_HAVE_EPOLL
+private:
+    // One non-blocking event loop per thread. Each worker owns its epoll
+    // instance (or io_uring) and connection table outright, so the request
+    // path never takes a lock; every socket is advanced through
+    // read -> process -> write without blocking, so a slow client only
+    // delays itself.
+    class Worker {
+    private:
+        SimpleHttpServer& server;
+        SOCKET listenSocket;
+        bool ownsListener;
+        int epollFd = -1;
+        vector<unique_ptr<Connection>> connections; // indexed by fd
+        
+        // Closed connections, reset and ready for the next accept. A client
+        // that connects, sends one request and hangs up then costs no
+        // allocation: the Connection, its receive buffer, output string and
+        // frame queue are all reused.
+        static const size_t MAX_SPARE_CONNECTIONS = 256;
+        vector<unique_ptr<Connection>> spareConnections;
+        LoopTimers timers;
+        chrono::steady_clock::time_point loopNow = chrono::steady_clock::now(); // read once per wakeup
+        
+        // Admission: this loop's share of --max-connections, and the earliest
+        // time the requests read in this wakeup can have arrived (noteWakeup)
+        int openConnections = 0;
+        int connectionCap;
+        chrono::steady_clock::time_point queuedSince = loopNow;
+        
+        // Room events for this loop's subscribers. Any thread may post to the
+        // mailbox; the loop drains it once per wakeup.
+        int index;
+        int wakeFd;                                       // eventfd written when the mailbox becomes non-empty
+        mutex mailLock;
+        vector<pair<uint64_t, PushFrame>> mailbox;
+        vector<pair<uint64_t, PushFrame>> inbox;          // the drained mailbox, reused between wakeups
+        unordered_map<uint64_t, vector<int>> subscribers; // room key -> streaming connections
+        vector<int> pushed;                               // connections with frames queued this wakeup
+        
+#ifdef SQUID_HAVE_URING
+        // The io_uring loop (--io=uring). Each completion's user data names
+        // the operation and the socket it was for.
+        enum RingOp : uint8_t { OP_ACCEPT, OP_RECV, OP_SEND, OP_SENDMSG, OP_POLLOUT, OP_WAKE, OP_IGNORE };
+        static const unsigned RING_ENTRIES = 1024;
+        static const unsigned RECV_BUFFERS = 512; // 2 MB of receive buffers per loop, shared by all its sockets
+        static const unsigned RECV_BUFFER_BYTES = 4096;
+        Uring ring;
+        uint64_t wakeCount = 0; // target of the eventfd read
+        
+        static uint64_t userData(RingOp op, int fd) { return ((uint64_t)op << 32) | (uint32_t)fd; }
+#endif
+        
+    public:
+        Worker(SimpleHttpServer& s, SOCKET listener, bool owns, int workerIndex)
+            : server(s), listenSocket(listener), ownsListener(owns),
+              connectionCap(s.config.maxConnections > 0
+                                ? max(1, (s.config.maxConnections + s.config.workers - 1) / s.config.workers)
+                                : INT_MAX),
+              index(workerIndex), wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+        
+        ~Worker() {
+            for (auto& conn : connections) {
+                if (conn) closesocket(conn->fd);
+            }
+            if (epollFd >= 0) close(epollFd);
+            if (wakeFd >= 0) close(wakeFd);
+            if (ownsListener) closesocket(listenSocket);
+        }
+        
+        // Queue a frame for this loop's subscribers in the room; any thread
+        void post(uint64_t room, const PushFrame& frame) {
+            bool wake;
+            {
+                lock_guard<mutex> guard(mailLock);
+                wake = mailbox.empty();
+                mailbox.emplace_back(room, frame);
+            }
+            if (wake) {
+                uint64_t one = 1;
+                ssize_t written = write(wakeFd, &one, sizeof(one));
+                (void)written; // a full counter already means a pending wakeup
+            }
+        }
+        
+        void run() {
+#ifdef SQUID_HAVE_URING
+            if (server.config.io == IoBackend::Uring) {
+                runUring();
+                return;
+            }
+#endif
+            setNonBlocking(listenSocket);
+            epollFd = epoll_create1(EPOLL_CLOEXEC);
+            if (epollFd < 0) {
+                SQUID_LOG(LogLevel::Error, "epoll_create1 failed");
+                return;
+            }
+            
+            // EPOLLEXCLUSIVE avoids waking every worker when the listener is shared
+            epoll_event ev = {};
+            ev.events = EPOLLIN | (ownsListener ? 0u : (uint32_t)EPOLLEXCLUSIVE);
+            ev.data.fd = listenSocket;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, listenSocket, &ev);
+            ev.events = EPOLLIN;
+            ev.data.fd = wakeFd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+            
+            vector<epoll_event> events(1024);
+            while (true) {
+                // Sleep until a socket is ready or the next timer is due
+                long long wait = timers.msUntilNext(loopNow);
+                auto waitStarted = chrono::steady_clock::now();
+                int n = epoll_wait(epollFd, events.data(), (int)events.size(), (int)min(wait, 60000LL));
+                if (n < 0 && errno != EINTR) {
+                    SQUID_LOG(LogLevel::Error, "epoll_wait failed");
+                    break;
+                }
+                
+                // Due timers run before any request is judged
+                noteWakeup(waitStarted);
+                timers.advance(loopNow, [&](const LoopTimer& timer) { onTimer(timer); });
+                
+
+                for (int i = 0; i < n; i++) {
+                    int fd = events[i].data.fd;
+                    uint32_t flags = events[i].events;
+                    
+                    if (fd == listenSocket) {
+                        acceptConnections();
+                        continue;
+                    }
+                    if (fd == wakeFd) {
+                        uint64_t count;
+                        ssize_t drained = read(wakeFd, &count, sizeof(count));
+                        (void)drained; // the frames are picked up by deliverPushes below
+                        continue;
+                    }
+                    if (flags & (EPOLLERR | EPOLLHUP)) {
+                        closeConnection(fd);
+                        continue;
+                    }
+                    // A timer above or an earlier event may have closed it already
+                    if (fd >= (int)connections.size() || !connections[fd]) continue;
+                    if (flags & EPOLLIN) onReadable(fd);
+                    if ((flags & EPOLLOUT) && fd < (int)connections.size() && connections[fd]) flush(fd);
+                }
+                
+                deliverPushes();
+            }
+        }
+        
+    private:
+        // Everything read in this wakeup arrived after the previous one
+        // (loopNow), or later if the loop slept. The wait call also does the
+        // kernel's share of the previous pass's I/O (io_uring runs queued
+        // sends inside it), taken to be at most that pass's own time plus
+        // SLACK. Only wait time beyond that counts as sleep. The estimate is
+        // then late by at most one pass, never by the time spent idle.
+        void noteWakeup(chrono::steady_clock::time_point waitStarted) {
+            static const auto SLACK = chrono::milliseconds(1);
+            auto woke = chrono::steady_clock::now();
+            auto slept = (woke - waitStarted) - (waitStarted - loopNow) - SLACK;
+            queuedSince = slept > slept.zero() ? min(woke, loopNow + slept) : loopNow;
+            loopNow = woke;
+        }
+        
+        static void setNonBlocking(int fd) {
+            int flags = fcntl(fd, F_GETFL, 0);
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        }
+        
+        void acceptConnections() {
+            while (true) {
+                sockaddr_in peer = {};
+                socklen_t peerLen = sizeof(peer);
+                SOCKET clientSocket = accept4(listenSocket, (sockaddr*)&peer, &peerLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (clientSocket == INVALID_SOCKET) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                    if (errno == EINTR || errno == ECONNABORTED) continue;
+                    Metrics::local().acceptErrors.add();
+                    SQUID_LOG(LogLevel::Error, "accept failed");
+                    return;
+                }
+                
+                if (openConnections >= connectionCap) {
+                    rejectConnection(clientSocket);
+                    continue;
+                }
+                adoptConnection(clientSocket, peer.sin_addr.s_addr);
+                
+                // Edge-triggered on both directions: EPOLLOUT only fires when the
+                // send buffer frees up, so it never has to be toggled per response
+                epoll_event ev = {};
+                ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+                ev.data.fd = clientSocket;
+                epoll_ctl(epollFd, EPOLL_CTL_ADD, clientSocket, &ev);
+            }
+        }
+        
+        // Past the connection limit: a best-effort 503 and close, without
+        // reading the request. Cheaper than letting the client time out in the backlog.
+        void rejectConnection(SOCKET clientSocket) {
+            Metrics::local().connectionsRejected.add();
+#ifdef SQUID_HAVE_URING
+            if (ring.isOpen()) {
+                // Linked so the close runs after the send, whether or not it succeeded
+                if (ring.reserve(2)) {
+                    io_uring_sqe* sendEntry = ring.nextSqe();
+                    Uring::prepSend(sendEntry, clientSocket, CONNECTION_LIMIT_RESPONSE, sizeof(CONNECTION_LIMIT_RESPONSE) - 1,
+                                    userData(OP_IGNORE, clientSocket));
+                    sendEntry->flags |= IOSQE_IO_HARDLINK;
+                    Uring::prepClose(ring.nextSqe(), clientSocket, userData(OP_IGNORE, clientSocket));
+                } else {
+                    closesocket(clientSocket);
+                }
+                return;
+            }
+#endif
+            ssize_t sent = send(clientSocket, CONNECTION_LIMIT_RESPONSE, sizeof(CONNECTION_LIMIT_RESPONSE) - 1, MSG_NOSIGNAL);
+            (void)sent; // nothing more to do for this client either way
+            closesocket(clientSocket);
+        }
+        
+        // A Connection for a newly accepted socket, with its idle timer armed
+        Connection& adoptConnection(SOCKET clientSocket, uint32_t peer) {
+            if (clientSocket >= (int)connections.size()) {
+                connections.resize(clientSocket + 1);
+            }
+            if (spareConnections.empty()) {
+                connections[clientSocket].reset(new Connection());
+                connections[clientSocket]->parser = HttpRequestParser(MAX_REQUEST_SIZE);
+            } else {
+                connections[clientSocket] = move(spareConnections.back());
+                spareConnections.pop_back();
+            }
+            Connection& conn = *connections[clientSocket];
+            conn.fd = clientSocket;
+            conn.peer = peer;
+            conn.lastActive = loopNow;
+            openConnections++;
+            conn.idleTimer = timers.schedule(server.config.keepAliveTimeoutSec * 1000ull, LoopTimer::connection(clientSocket));
+            Metrics::local().connectionsOpened.add();
+            return conn;
+        }
+        
+        void onReadable(int fd) {
+            Connection& conn = *connections[fd];
+            conn.lastActive = loopNow;
+            if (!conn.heldBack) conn.queuedSince = queuedSince;
+            if (!readInput(fd)) return;
+            processPending(conn);
+            flush(fd);
+        }
+        
+        // Read what the socket has into conn.in. Once MAX_PENDING_INPUT is
+        // buffered and the requests in it cannot be answered yet, this stops
+        // with readPaused set and flush() resumes it. False if the connection
+        // was closed.
+        bool readInput(int fd) {
+            Connection& conn = *connections[fd];
+            conn.readPaused = false;
+            while (true) {
+                if (conn.in.size() >= MAX_PENDING_INPUT) {
+                    processPending(conn);
+                    if (conn.in.size() >= MAX_PENDING_INPUT) {
+                        conn.readPaused = true;
+                        return true;
+                    }
+                }
+                // Receive straight into the connection buffer; no staging copy
+                char* dest = conn.in.writePtr(4096);
+                ssize_t bytesRead = recv(fd, dest, conn.in.writableSize(), 0);
+                if (bytesRead > 0) {
+                    conn.in.commit(bytesRead);
+                    Metrics::local().bytesIn.add(bytesRead);
+                    continue;
+                }
+                if (bytesRead == 0) {
+                    // Client finished sending; still answer what it already sent
+                    conn.peerClosed = true;
+                    break;
+                }
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                closeConnection(fd);
+                return false;
+            }
+            return true;
+        }
+        
+        // Answer every complete request buffered on the connection, in order.
+        // A malformed or oversized request gets an error response and the
+        // connection is closed once it has been written.
+        void processPending(Connection& conn) {
+            if (conn.streaming) {
+                conn.in.consume(conn.in.size()); // a stream takes no further requests
+                return;
+            }
+            bool incomplete = false;
+            while (!conn.closeAfterWrite && !conn.streaming && conn.file.remaining == 0 &&
+                   conn.out.size() - conn.outSent < MAX_PENDING_OUTPUT) {
+                HttpRequest request;
+                HttpRequestParser::Status status = conn.parser.parse(conn.in.readable(), request);
+                if (status == HttpRequestParser::Incomplete) {
+                    incomplete = true;
+                    break;
+                }
+                if (status != HttpRequestParser::Complete) {
+                    Metrics::local().parseFailures.add();
+                    HttpResponseWriter response(conn.out, false, server.config.keepAliveTimeoutSec);
+                    server.writeErrorResponse(status, response);
+                    conn.closeAfterWrite = true;
+                    break;
+                }
+                
+                // Serialized in place after any responses still waiting to be sent.
+                // A file body goes out after the buffer, so nothing is added
+                // behind it until it has been sent.
+                HttpResponseWriter response(conn.out, request.keepAlive, server.config.keepAliveTimeoutSec);
+                if (server.refuse(request, response, conn.peer, conn.queuedSince)) {
+                    conn.in.consume(request.length);
+                    conn.parser.reset();
+                    if (!request.keepAlive) conn.closeAfterWrite = true;
+                    continue;
+                }
+                
+                if (METHODS.lookup(request.method) == Method::Get && routeFor(request.path) == Route::Events) {
+                    openStream(conn, request);
+                    conn.in.consume(request.length);
+                    conn.parser.reset();
+                    break;
+                }
+                
+                server.processRequest(request, response, timers, &conn.file);
+                conn.in.consume(request.length);
+                conn.parser.reset();
+                if (!request.keepAlive) conn.closeAfterWrite = true;
+            }
+            conn.heldBack = !incomplete && conn.in.size() > 0;
+        }
+        
+        // Push as much pending output as the socket accepts. On a short write
+        // we return and resume on the next EPOLLOUT; once drained, any
+        // pipelined requests held back by MAX_PENDING_OUTPUT are answered
+        // and a paused read is picked up again.
+        void flush(int fd) {
+#ifdef SQUID_HAVE_URING
+            if (ring.isOpen()) {
+                flushRing(fd);
+                return;
+            }
+#endif
+            Connection& conn = *connections[fd];
+            while (true) {
+                while (conn.outSent < conn.out.size()) {
+                    ssize_t sent = send(fd, conn.out.data() + conn.outSent, conn.out.size() - conn.outSent, MSG_NOSIGNAL);
+                    if (sent > 0) {
+                        conn.outSent += sent;
+                        Metrics::local().bytesOut.add(sent);
+                        continue;
+                    }
+                    if (sent < 0 && errno == EINTR) continue;
+                    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+                    closeConnection(fd);
+                    return;
+                }
+                // A static file whose headers ended the buffer
+                while (conn.file.remaining > 0) {
+                    off_t offset = (off_t)conn.file.offset;
+                    ssize_t sent = sendfile(fd, conn.file.fd, &offset, conn.file.remaining);
+                    if (sent > 0) {
+                        conn.file.offset = offset;
+                        conn.file.remaining -= (size_t)sent;
+                        Metrics::local().bytesOut.add(sent);
+                        Metrics::local().staticFileBytes.add(sent);
+                        continue;
+                    }
+                    if (sent < 0 && errno == EINTR) continue;
+                    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+                    closeConnection(fd); // includes a file that shrank under us
+                    return;
+                }
+                conn.out.clear();
+                conn.outSent = 0;
+                
+                if (conn.streaming) {
+                    flushFrames(fd);
+                    return;
+                }
+                if (conn.closeAfterWrite) {
+                    closeConnection(fd);
+                    return;
+                }
+                processPending(conn);
+                if (conn.readPaused && conn.in.size() < MAX_PENDING_INPUT) {
+                    // Edge-triggered: what is already in the socket raises no new EPOLLIN
+                    if (!readInput(fd)) return;
+                    processPending(conn);
+                }
+                if (conn.out.empty()) {
+                    if (conn.peerClosed) closeConnection(fd);
+                    return;
+                }
+            }
+        }
+        
+        // Send queued event frames, several per sendmsg. The frames are shared
+        // with every other subscriber in the room, so they are never copied.
+        void flushFrames(int fd) {
+            Connection& conn = *connections[fd];
+            while (!conn.frames.empty()) {
+                iovec iov[16];
+                int count = 0;
+                for (size_t i = 0; i < conn.frames.size() && count < 16; i++, count++) {
+                    size_t skip = (i == 0) ? conn.frameSent : 0;
+                    iov[count].iov_base = (void*)(conn.frames[i]->data() + skip);
+                    iov[count].iov_len = conn.frames[i]->size() - skip;
+                }
+                msghdr msg = {};
+                msg.msg_iov = iov;
+                msg.msg_iovlen = count;
+                ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+                if (sent < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                    closeConnection(fd);
+                    return;
+                }
+                Metrics::local().bytesOut.add(sent);
+                conn.framesBytes -= sent;
+                size_t done = conn.frameSent + (size_t)sent;
+                while (!conn.frames.empty() && done >= conn.frames.front()->size()) {
+                    done -= conn.frames.front()->size();
+                    conn.frames.pop_front();
+                }
+                conn.frameSent = done;
+            }
+            if (conn.peerClosed) closeConnection(fd);
+        }
+        
+        // Turn the connection into the room's event stream: headers, the
+        // room's current state, then every event the room publishes. The
+        // loop subscribes before reading the state, so no event falls between.
+        void openStream(Connection& conn, const HttpRequest& request) {
+            string room;
+            queryParam(request.path, "room", room);
+            uint64_t key = roomKey(room);
+            
+            vector<int>& fds = subscribers[key];
+            fds.push_back(conn.fd);
+            if (fds.size() == 1) server.pushHub.join(key, index);
+            conn.streaming = true;
+            conn.streamRoom = key;
+            Metrics::local().streamsOpened.add();
+            
+            HttpResponseWriter response(conn.out, true, server.config.keepAliveTimeoutSec);
+            response.beginStream("text/event-stream");
+            conn.out.append("retry: 2000\n\n"); // EventSource reconnects after 2 s and gets a fresh snapshot
+            server.writeRoomSnapshot(timers, key, conn.out);
+        }
+        
+        void closeStream(Connection& conn) {
+            auto it = subscribers.find(conn.streamRoom);
+            if (it == subscribers.end()) return;
+            vector<int>& fds = it->second;
+            fds.erase(find(fds.begin(), fds.end(), conn.fd));
+            if (fds.empty()) {
+                subscribers.erase(it);
+                server.pushHub.leave(conn.streamRoom, index);
+            }
+            Metrics::local().streamsClosed.add();
+        }
+        
+        // Hand the frames posted since the last wakeup to this loop's
+        // subscribers. Every frame is queued first and the connections are
+        // flushed after, so one closing midway cannot disturb the room lists.
+        void deliverPushes() {
+            {
+                lock_guard<mutex> guard(mailLock);
+                if (mailbox.empty()) return;
+                inbox.swap(mailbox);
+            }
+            for (auto& item : inbox) {
+                auto it = subscribers.find(item.first);
+                if (it == subscribers.end()) continue; // the last subscriber left after the post
+                for (int fd : it->second) {
+                    Connection& conn = *connections[fd];
+                    conn.frames.push_back(item.second);
+                    conn.framesBytes += item.second->size();
+                    if (!conn.flushQueued) {
+                        conn.flushQueued = true;
+                        pushed.push_back(fd);
+                    }
+                }
+                Metrics::local().eventDeliveries.add(it->second.size());
+            }
+            inbox.clear();
+            
+            for (int fd : pushed) {
+                Connection& conn = *connections[fd];
+                conn.flushQueued = false;
+                // A subscriber this far behind is dropped; its EventSource
+                // reconnects and starts again from a snapshot
+                if (conn.framesBytes > MAX_PENDING_OUTPUT) closeConnection(fd);
+                else flush(fd);
+            }
+            pushed.clear();
+        }
+        
+        void onTimer(const LoopTimer& timer) {
+            if (timer.kind == LoopTimer::IDLE_CONNECTION) {
+                onIdleTimer(timer.fd);
+            } else {
+                server.onRoomTimer(timers, timer);
+            }
+        }
+        
+        // Activity does not touch the timer; when it fires, a connection that
+        // was active meanwhile is simply re-armed for the rest of its timeout
+        void onIdleTimer(int fd) {
+            Connection& conn = *connections[fd]; // closeConnection cancels the timer, so fd is still ours
+            conn.idleTimer = 0;
+            auto timeout = chrono::seconds(server.config.keepAliveTimeoutSec);
+            if (conn.streaming) {
+                // Streams stay open. A comment line each timeout keeps proxies
+                // from cutting them and shows up dead peers as send errors.
+                static const PushFrame heartbeat = make_shared<const string>(": keep-alive\n\n");
+                conn.frames.push_back(heartbeat);
+                conn.framesBytes += heartbeat->size();
+                conn.idleTimer = timers.schedule(server.config.keepAliveTimeoutSec * 1000ull, LoopTimer::connection(fd));
+                flush(fd);
+                return;
+            }
+            auto idle = loopNow - conn.lastActive;
+            if (idle >= timeout) {
+                closeConnection(fd);
+                return;
+            }
+            auto left = chrono::ceil<chrono::milliseconds>(timeout - idle).count();
+            conn.idleTimer = timers.schedule((uint64_t)left, LoopTimer::connection(fd));
+        }
+        
+        void closeConnection(int fd) {
+            if (fd < 0 || fd >= (int)connections.size() || !connections[fd]) return;
+#ifdef SQUID_HAVE_URING
+            if (ring.isOpen()) {
+                closeRingConnection(fd);
+                return;
+            }
+#endif
+            timers.cancel(connections[fd]->idleTimer);
+            if (connections[fd]->streaming) closeStream(*connections[fd]);
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            closesocket(fd);
+            releaseConnection(fd);
         }
         
-        // Parse request path and body
-        size_t pathStart = request.find(" ") + 1;
-        size_t pathEnd = request.find(" ", pathStart);
-        string path = request.substr(pathStart, pathEnd - pathStart);
+        // Back to the spares, or freed if there are enough
+        void releaseConnection(int fd) {
+            openConnections--;
+            if (spareConnections.size() < MAX_SPARE_CONNECTIONS) {
+                connections[fd]->recycle();
+                spareConnections.push_back(move(connections[fd]));
+            } else {
+                connections[fd].reset();
+            }
+            Metrics::local().connectionsClosed.add();
+        }
         
-        // Extract JSON body
-        size_t bodyStart = request.find("\r\n\r\n");
-        string body = "";
-        if (bodyStart != string::npos) {
-            body = request.substr(bodyStart + 4);
+#ifdef SQUID_HAVE_URING
+        // ---- io_uring loop ----
+        // Accepts and receives are multishot: armed once, they post a
+        // completion per connection or per chunk of data until cancelled.
+        // Received data lands in buffers the loop registered with the
+        // kernel. Everything queued while handling one batch of completions,
+        // the next batch and the timer wait go to the kernel in a single
+        // io_uring_enter. Only sendfile, for large static files, is still a
+        // system call of its own.
+        void runUring() {
+            string error;
+            if (!ring.open(RING_ENTRIES, true, error) || !ring.setupBuffers(RECV_BUFFERS, RECV_BUFFER_BYTES, error)) {
+                SQUID_LOG(LogLevel::Error, "io_uring setup failed");
+                return;
+            }
+            // The ring waits on the eventfd itself; a non-blocking read would just fail
+            fcntl(wakeFd, F_SETFL, fcntl(wakeFd, F_GETFL, 0) & ~O_NONBLOCK);
+            armAccept();
+            armWake();
+            
+            while (true) {
+                long long wait = timers.msUntilNext(loopNow);
+                auto waitStarted = chrono::steady_clock::now();
+                if (ring.submitAndWait(min(wait, 60000LL)) < 0 && errno != EINTR && errno != ETIME && errno != EBUSY) {
+                    SQUID_LOG(LogLevel::Error, "io_uring_enter failed");
+                    break;
+                }
+                
+                // Due timers run before any request is judged
+                noteWakeup(waitStarted);
+                timers.advance(loopNow, [&](const LoopTimer& timer) { onTimer(timer); });
+                
+                ring.drain([&](const io_uring_cqe& cqe) { onCompletion(cqe); });
+                deliverPushes();
+            }
         }
         
-        cout << "Request: " << path << endl;
+        // A submission entry; nullptr only if the kernel takes no more work
+        io_uring_sqe* sqe() {
+            io_uring_sqe* entry = ring.nextSqe();
+            if (!entry) SQUID_LOG(LogLevel::Error, "io_uring submission queue full");
+            return entry;
+        }
+        
+        void armAccept() {
+            if (io_uring_sqe* entry = sqe()) Uring::prepMultishotAccept(entry, listenSocket, userData(OP_ACCEPT, listenSocket));
+        }
         
-        // Route to appropriate game handler
-        if (path == "/redlight") {
-            string playerName = parseJsonField(body, "playerName");
-            string action = parseJsonField(body, "action");
-            int position = parseJsonInt(body, "position");
-            return RedLightGreenLightGame::processAction(playerName, action, position);
+        void armWake() {
+            if (io_uring_sqe* entry = sqe()) Uring::prepRead(entry, wakeFd, &wakeCount, sizeof(wakeCount), userData(OP_WAKE, wakeFd));
         }
-        else if (path == "/glassbridge") {
-            string playerName = parseJsonField(body, "playerName");
-            string choice = parseJsonField(body, "choice");
-            int step = parseJsonInt(body, "step");
-            return GlassBridgeGame::processChoice(playerName, choice, step);
+        
+        bool armRecv(Connection& conn) {
+            io_uring_sqe* entry = sqe();
+            if (!entry) return false;
+            Uring::prepMultishotRecv(entry, conn.fd, userData(OP_RECV, conn.fd));
+            conn.inflight++;
+            conn.recvArmed = true;
+            return true;
+        }
+        
+        // readInput() for the io_uring loop: once MAX_PENDING_INPUT waits on
+        // held-back output, the multishot recv is cancelled, and flushRing
+        // arms a new one when the output drains. Completions already posted
+        // still arrive and are kept.
+        void pauseRecv(Connection& conn) {
+            if (conn.readPaused || conn.in.size() < MAX_PENDING_INPUT) return;
+            conn.readPaused = true;
+            if (!conn.recvArmed) return;
+            if (io_uring_sqe* entry = sqe()) Uring::prepCancel(entry, userData(OP_RECV, conn.fd), userData(OP_IGNORE, conn.fd));
         }
-        else if (path == "/tugofwar") {
-            string playerName = parseJsonField(body, "playerName");
-            int strength = parseJsonInt(body, "strength");
-            int turn = parseJsonInt(body, "turn");
-            int opponentStrength = parseJsonInt(body, "opponentStrength");
-            string strategy = parseJsonField(body, "strategy");
-            return TugOfWarGame::processPull(playerName, strength, turn, opponentStrength, strategy);
+        
+        void onCompletion(const io_uring_cqe& cqe) {
+            RingOp op = (RingOp)(cqe.user_data >> 32);
+            int fd = (int)(uint32_t)cqe.user_data;
+            bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+            switch (op) {
+                case OP_ACCEPT:
+                    if (cqe.res >= 0 && openConnections >= connectionCap) {
+                        rejectConnection(cqe.res);
+                    } else if (cqe.res >= 0) {
+                        // Multishot accept cannot return each peer's address,
+                        // so it is looked up only when the rate limiter needs it
+                        sockaddr_in peer = {};
+                        socklen_t peerLen = sizeof(peer);
+                        if (server.rateLimiter.enabled()) getpeername(cqe.res, (sockaddr*)&peer, &peerLen);
+                        Connection& conn = adoptConnection(cqe.res, peer.sin_addr.s_addr);
+                        if (!armRecv(conn)) closeConnection(conn.fd);
+                    } else if (cqe.res != -ECONNABORTED && cqe.res != -EINTR) {
+                        Metrics::local().acceptErrors.add();
+                        SQUID_LOG(LogLevel::Error, "accept failed");
+                    }
+                    if (!more) armAccept();
+                    return;
+                case OP_WAKE:
+                    armWake(); // the frames are picked up by deliverPushes
+                    return;
+                case OP_IGNORE:
+                    return;
+                default:
+                    break;
+            }
+            
+            Connection& conn = *connections[fd]; // not released while it has operations in flight
+            if (op == OP_RECV) {
+                if (!more) conn.inflight--;
+                onReceived(conn, cqe, more);
+            } else {
+                conn.inflight--;
+                conn.sendInFlight = false;
+                if (!conn.closing) onSent(conn, op, cqe.res);
+            }
+            if (conn.closing && conn.inflight == 0) finishClose(fd);
+        }
+        
+        void onReceived(Connection& conn, const io_uring_cqe& cqe, bool more) {
+            if (!more) conn.recvArmed = false;
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                uint16_t id = (uint16_t)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                if (cqe.res > 0 && !conn.closing) {
+                    memcpy(conn.in.writePtr((size_t)cqe.res), ring.buffer(id), (size_t)cqe.res);
+                    conn.in.commit((size_t)cqe.res);
+                    Metrics::local().bytesIn.add(cqe.res);
+                }
+                ring.recycleBuffer(id);
+            }
+            if (conn.closing) return;
+            if (cqe.res == 0) {
+                // Client finished sending; still answer what it already sent
+                conn.peerClosed = true;
+            } else if (cqe.res < 0) {
+                // Out of buffers, interrupted or paused: the data waits in the
+                // socket. A pause lifted before its cancel landed rearms here.
+                if (cqe.res == -ENOBUFS || cqe.res == -EAGAIN || cqe.res == -EINTR || cqe.res == -ECANCELED) {
+                    if (!more && !conn.readPaused && !armRecv(conn)) closeConnection(conn.fd);
+                    return;
+                }
+                closeConnection(conn.fd);
+                return;
+            } else if (!more && !conn.readPaused && !armRecv(conn)) {
+                closeConnection(conn.fd);
+                return;
+            }
+            conn.lastActive = loopNow;
+            if (!conn.heldBack) conn.queuedSince = queuedSince;
+            // A send in flight still reads from conn.out; its completion
+            // answers what arrived in the meantime
+            if (conn.sendInFlight) {
+                conn.heldBack = true;
+                pauseRecv(conn);
+                return;
+            }
+            processPending(conn);
+            pauseRecv(conn);
+            flushRing(conn.fd);
         }
-        else {
-            map<string, string> error;
-            error["error"] = "Unknown endpoint";
-            return createJsonResponse(error);
+        
+        void onSent(Connection& conn, RingOp op, int res) {
+            if (res == -EAGAIN || res == -EINTR || op == OP_POLLOUT) {
+                flushRing(conn.fd);
+                return;
+            }
+            if (res <= 0) {
+                closeConnection(conn.fd);
+                return;
+            }
+            Metrics::local().bytesOut.add(res);
+            if (op == OP_SEND) {
+                conn.outSent += (size_t)res;
+            } else {
+                conn.framesBytes -= (size_t)res;
+                size_t done = conn.frameSent + (size_t)res;
+                while (!conn.frames.empty() && done >= conn.frames.front()->size()) {
+                    done -= conn.frames.front()->size();
+                    conn.frames.pop_front();
+                }
+                conn.frameSent = done;
+            }
+            flushRing(conn.fd);
+        }
+        
+        // flush() for the io_uring loop: the same order (buffer, file body,
+        // then frames or the next pipelined requests), but one send at a
+        // time is handed to the kernel and this returns until it completes
+        void flushRing(int fd) {
+            Connection& conn = *connections[fd];
+            if (conn.closing || conn.sendInFlight) return;
+            while (true) {
+                if (conn.outSent < conn.out.size()) {
+                    io_uring_sqe* entry = sqe();
+                    if (!entry) {
+                        closeConnection(fd);
+                        return;
+                    }
+                    Uring::prepSend(entry, fd, conn.out.data() + conn.outSent, conn.out.size() - conn.outSent, userData(OP_SEND, fd));
+                    startSend(conn);
+                    return;
+                }
+                while (conn.file.remaining > 0) {
+                    off_t offset = (off_t)conn.file.offset;
+                    ssize_t sent = sendfile(fd, conn.file.fd, &offset, conn.file.remaining);
+                    if (sent > 0) {
+                        conn.file.offset = offset;
+                        conn.file.remaining -= (size_t)sent;
+                        Metrics::local().bytesOut.add(sent);
+                        Metrics::local().staticFileBytes.add(sent);
+                        continue;
+                    }
+                    if (sent < 0 && errno == EINTR) continue;
+                    io_uring_sqe* entry = (sent < 0 && errno == EAGAIN) ? sqe() : nullptr;
+                    if (!entry) {
+                        closeConnection(fd);
+                        return;
+                    }
+                    Uring::prepPollOut(entry, fd, userData(OP_POLLOUT, fd));
+                    startSend(conn);
+                    return;
+                }
+                conn.out.clear();
+                conn.outSent = 0;
+                
+                if (conn.streaming) {
+                    if (!conn.frames.empty()) sendFrames(conn);
+                    else if (conn.peerClosed) closeConnection(fd);
+                    return;
+                }
+                if (conn.closeAfterWrite) {
+                    closeConnection(fd);
+                    return;
+                }
+                processPending(conn);
+                if (conn.readPaused && conn.in.size() < MAX_PENDING_INPUT) {
+                    conn.readPaused = false;
+                    if (!conn.recvArmed && !armRecv(conn)) {
+                        closeConnection(fd);
+                        return;
+                    }
+                }
+                if (conn.out.empty()) {
+                    if (conn.peerClosed) closeConnection(fd);
+                    return;
+                }
+            }
+        }
+        
+        void startSend(Connection& conn) {
+            conn.inflight++;
+            conn.sendInFlight = true;
+        }
+        
+        // Up to 16 queued event frames in one sendmsg, read in place
+        void sendFrames(Connection& conn) {
+            int count = 0;
+            for (size_t i = 0; i < conn.frames.size() && count < 16; i++, count++) {
+                size_t skip = (i == 0) ? conn.frameSent : 0;
+                conn.sendIov[count].iov_base = (void*)(conn.frames[i]->data() + skip);
+                conn.sendIov[count].iov_len = conn.frames[i]->size() - skip;
+            }
+            conn.sendMsg = msghdr();
+            conn.sendMsg.msg_iov = conn.sendIov;
+            conn.sendMsg.msg_iovlen = count;
+            io_uring_sqe* entry = sqe();
+            if (!entry) {
+                closeConnection(conn.fd);
+                return;
+            }
+            Uring::prepSendmsg(entry, conn.fd, &conn.sendMsg, userData(OP_SENDMSG, conn.fd));
+            startSend(conn);
+        }
+        
+        // Stop the connection's operations; the socket is closed and the
+        // Connection released once the last of them has completed
+        void closeRingConnection(int fd) {
+            Connection& conn = *connections[fd];
+            if (conn.closing) return;
+            conn.closing = true;
+            timers.cancel(conn.idleTimer);
+            conn.idleTimer = 0;
+            if (conn.streaming) closeStream(conn);
+            if (conn.inflight == 0) {
+                finishClose(fd);
+                return;
+            }
+            if (io_uring_sqe* entry = sqe()) Uring::prepCancelAll(entry, fd, userData(OP_IGNORE, fd));
         }
+        
+        void finishClose(int fd) {
+            io_uring_sqe* entry = sqe();
+            if (entry) Uring::prepClose(entry, fd, userData(OP_IGNORE, fd));
+            else closesocket(fd);
+            releaseConnection(fd);
+        }
+#endif
+    };
+    
+public:
+#endif
+    
+    // withRoom that also arms the TTL timer of a room it creates and
+    // journals its seed
+    template <typename F>
+    void withRoom(LoopTimers& timers, uint64_t key, F&& fn) {
+        uint32_t id = 0;
+        bool created = sessions.withRoom(key, [&](RoomState& room, bool isNew) {
+            id = room.id;
+            if (isNew) journal(JournalEntry(JournalKind::Created, key, room.seed));
+            fn(room);
+        });
+        if (created) timers.schedule(sessions.ttl() * 1000ull, LoopTimer::room(LoopTimer::ROOM_TTL, key, id));
+    }
+    
+    // ================= Room Events =================
+    // Send an event to everyone subscribed to the room. fill(JsonWriter&)
+    // writes the data; it only runs if someone is listening, and then once.
+    template <size_t N, typename F>
+    void publish(uint64_t room, const char (&event)[N], F&& fill) {
+#ifdef SQUID_HAVE_EPOLL
+        uint64_t loops = pushHub.loopsFor(room);
+        if (!loops) return;
+        PushFrame frame = makePushFrame(event, fill);
+        Metrics::local().eventsPublished.add();
+        for (size_t i = 0; i < workers.size(); i++) {
+            if (loops & PushHub::loopBit((int)i)) workers[i]->post(room, frame);
+        }
+#endif
+    }
+    
+    void publishLight(uint64_t room, RoomLight light) {
+        publish(room, "light", [&](JsonWriter& json) { json.text("light", lightName(light)); });
+    }
+    
+    // rawPlayerName still has the request's JSON escapes; it is decoded so
+    // the writer does not escape them a second time
+    void publishElimination(uint64_t room, string_view game, string_view rawPlayerName, string_view message) {
+        publish(room, "eliminated", [&](JsonWriter& json) {
+            thread_local string playerName; // keeps its capacity between events
+            playerName.clear();
+            appendJsonUnescaped(playerName, rawPlayerName);
+            json.text("game", game);
+            json.text("playerName", playerName);
+            json.text("message", message);
+        });
+    }
+    
+    // The light and every broken panel, as the events a new subscriber
+    // would have seen
+    void writeRoomSnapshot(LoopTimers& timers, uint64_t key, string& out) {
+        RoomState state;
+        withRoom(timers, key, [&](RoomState& room) { state = room; });
+        out.append(*makePushFrame("light", [&](JsonWriter& json) { json.text("light", lightName((RoomLight)state.light)); }));
+        for (int step = 0; step < BRIDGE_STEPS; step++) {
+            for (int panel = 0; panel < 2; panel++) {
+                if (!state.isBroken(step, panel)) continue;
+                out.append(*makePushFrame("panel", [&](JsonWriter& json) {
+                    json.number("step", step);
+                    json.text("panel", panelName((Panel)panel));
+                }));
+            }
+        }
+    }
+    
+    // Entries that change a record are journaled inside withRoom, under the
+    // record's lock (see journal.h)
+    static void journal(const JournalEntry& entry) {
+        Journal& journal = Journal::instance();
+        if (journal.enabled()) journal.record(entry);
+    }
+    
+    // Room timers; connection timers are handled by the worker owning the socket
+    void onRoomTimer(LoopTimers& timers, const LoopTimer& timer) {
+        switch (timer.kind) {
+            case LoopTimer::ROOM_TTL:
+                if (uint32_t left = sessions.expireIfIdle(timer.key, timer.roomId)) {
+                    timers.schedule(left * 1000ull, timer);
+                }
+                break;
+            case LoopTimer::LIGHT_CHANGE: {
+                uint32_t phaseMs = 0;
+                RoomLight light = LIGHT_OFF;
+                bool exists = sessions.withExistingRoom(timer.key, timer.roomId, [&](RoomState& room) {
+                    if (coarseNowSeconds() - room.lastSeen >= (uint32_t)RedLightGreenLightGame::LIGHT_IDLE_SECONDS) {
+                        room.light = LIGHT_OFF; // the next request starts it again
+                        journal(JournalEntry(JournalKind::LightOff, timer.key));
+                        return;
+                    }
+                    phaseMs = RedLightGreenLightGame::flipLight(room);
+                    light = (RoomLight)room.light;
+                    JournalEntry entry(JournalKind::LightFlip, timer.key);
+                    entry.a = room.light;
+                    journal(entry);
+                });
+                if (phaseMs) timers.schedule(phaseMs, timer);
+                if (exists) publishLight(timer.key, light);
+                break;
+            }
+            case LoopTimer::RUN_DEADLINE:
+                sessions.withExistingRoom(timer.key, timer.roomId, [&](RoomState& run) {
+                    if (run.runEpoch != timer.epoch) return;
+                    run.runExpired = true;
+                    JournalEntry entry(JournalKind::RunExpired, timer.key);
+                    entry.x = run.runEpoch;
+                    journal(entry);
+                });
+                break;
+            default:
+                break;
+        }
+    }
+    
+    // ================= Results =================
+    // A run that ended: Red Light when the player is shot or out of time
+    // (score: position), Glass Bridge on a fall or on the last step (steps
+    // crossed), Tug of War on the final turn (strength). Queued for the
+    // results log without waiting on it.
+    void recordResult(ResultGame game, string_view rawPlayerName, int score, bool survived) {
+        ResultsStore& results = ResultsStore::instance();
+        if (!results.enabled()) return;
+        thread_local string playerName; // keeps its capacity between results
+        playerName.clear();
+        appendJsonUnescaped(playerName, rawPlayerName);
+        if (results.record(makeResult(game, playerName, (uint32_t)max(score, 0), survived))) {
+            Metrics::local().resultsRecorded.add();
+        } else {
+            Metrics::local().resultsDropped.add();
+        }
+    }
+    
+    // GET /leaderboard?game=NAME[&limit=N]: each player's best result in the
+    // game, best first; limit defaults to 10 and is capped at 100
+    void writeLeaderboard(string_view target, HttpResponseWriter& response) {
+        string gameName, limitText;
+        queryParam(target, "game", gameName);
+        ResultGame game = parseResultGame(gameName);
+        if (game == ResultGame::Count) {
+            writeJsonError(response.begin(400), "Unknown game");
+            return;
+        }
+        int limit = 10;
+        if (queryParam(target, "limit", limitText)) limit = min(max(atoi(limitText.c_str()), 1), 100);
+        
+        JsonWriter& json = response.begin(200);
+        json.beginObject();
+        json.text("game", resultGameName(game));
+        json.beginArray("entries");
+        int rank = 0;
+        ResultsStore::instance().top(game, (size_t)limit, [&](const ResultRecord& r) {
+            json.element();
+            json.beginObject();
+            json.number("rank", ++rank);
+            json.text("playerName", r.playerName());
+            json.number("score", r.score);
+            json.flag("survived", r.survived != 0);
+            json.number("time", (long long)r.timeMs);
+            json.endObject();
+        });
+        json.endArray();
+        json.endObject();
+    }
+    
+    // One game action: the body a game endpoint takes, sent to `route`.
+    // begin(status) starts the result object and returns its writer, so the
+    // same code answers a single request and fills one element of a /batch.
+    // Returns the metrics route.
+    template <typename Begin>
+    int runAction(Route route, string_view body, LoopTimers& timers, Begin&& begin) {
+        // Every game runs in a room; clients that do not name one share the
+        // default room. Words from the body are decoded to enums here, once.
+        switch (route) {
+            case Route::RedLight: {
+                string_view room, playerName, action;
+                int position = 0;
+                extractJsonFields(body, {{"room", &room}, {"playerName", &playerName}, {"action", &action}, {"position", &position}});
+                uint64_t key = roomKey(room);
+                
+                // The player's run; position 0 starts a new one with a fresh deadline
+                uint64_t run = runKey(key, playerName);
+                bool expired = false, started = false;
+                uint32_t runId = 0;
+                uint16_t epoch = 0;
+                withRoom(timers, run, [&](RoomState& state) {
+                    if (position == 0 || state.runEpoch == 0) {
+                        RedLightGreenLightGame::startRun(state);
+                        started = true;
+                        runId = state.id;
+                        epoch = state.runEpoch;
+                        JournalEntry entry(JournalKind::RunStart, run, key);
+                        entry.x = epoch;
+                        journal(entry);
+                    }
+                    expired = state.runExpired;
+                });
+                if (started) {
+                    timers.schedule(RedLightGreenLightGame::RUN_SECONDS * 1000ull,
+                                    LoopTimer::room(LoopTimer::RUN_DEADLINE, run, runId, epoch));
+                }
+                
+                // The room's light; the first request in a quiet room switches
+                // it on. The action is judged and journaled under the room's
+                // lock, so its entry is numbered among the light's changes.
+                RedLightAction decoded = parseRedLightAction(action);
+                RoomLight light = LIGHT_OFF;
+                RedLightResult result;
+                uint32_t roomId = 0, phaseMs = 0;
+                withRoom(timers, key, [&](RoomState& state) {
+                    if (state.light == LIGHT_OFF) {
+                        phaseMs = RedLightGreenLightGame::switchOn(state);
+                        roomId = state.id;
+                        JournalEntry entry(JournalKind::LightOn, key);
+                        entry.a = state.light;
+                        journal(entry);
+                    }
+                    light = (RoomLight)state.light;
+                    result = expired ? RedLightGreenLightGame::timeUp(light, position)
+                                     : RedLightGreenLightGame::processAction(light, decoded, position);
+                    JournalEntry entry(JournalKind::RedLight, key, roomKey(playerName));
+                    entry.a = (uint8_t)decoded;
+                    entry.b = light;
+                    entry.x = position;
+                    entry.result = result.position;
+                    entry.flags = (result.survived ? JournalEntry::SURVIVED : 0) | (expired ? JournalEntry::EXPIRED : 0);
+                    journal(entry);
+                });
+                if (phaseMs) {
+                    timers.schedule(phaseMs, LoopTimer::room(LoopTimer::LIGHT_CHANGE, key, roomId));
+                    publishLight(key, light);
+                }
+                writeJson(begin(200), result);
+                if (!result.survived) {
+                    publishElimination(key, "redlight", playerName, result.message);
+                    recordResult(ResultGame::RedLight, playerName, result.position, false);
+                }
+                return ROUTE_REDLIGHT;
+            }
+            case Route::GlassBridge: {
+                string_view room, playerName, choiceWord;
+                int step = 0;
+                extractJsonFields(body, {{"room", &room}, {"playerName", &playerName}, {"choice", &choiceWord}, {"step", &step}});
+                if (step < 0 || step >= BRIDGE_STEPS) {
+                    writeJsonError(begin(400), "Invalid step");
+                    return ROUTE_GLASSBRIDGE;
+                }
+                Panel choice = parsePanel(choiceWord);
+                GlassBridgeResult result;
+                uint64_t key = roomKey(room);
+                bool broke = false;
+                withRoom(timers, key, [&](RoomState& state) {
+                    uint64_t before = state.brokenPanels;
+                    result = GlassBridgeGame::processChoice(state, choice, step);
+                    broke = state.brokenPanels != before;
+                    JournalEntry entry(JournalKind::GlassBridge, key, roomKey(playerName));
+                    entry.a = (uint8_t)choice;
+                    entry.b = (uint8_t)result.correctChoice;
+                    entry.x = step;
+                    entry.flags = result.survived ? JournalEntry::SURVIVED : 0;
+                    journal(entry);
+                });
+                writeJson(begin(200), result);
+                if (broke) {
+                    publish(key, "panel", [&](JsonWriter& json) {
+                        json.number("step", step);
+                        json.text("panel", panelName(choice));
+                    });
+                }
+                if (!result.survived) {
+                    publishElimination(key, "glassbridge", playerName, result.message);
+                    recordResult(ResultGame::GlassBridge, playerName, step, false);
+                } else if (step == BRIDGE_STEPS - 1) {
+                    recordResult(ResultGame::GlassBridge, playerName, BRIDGE_STEPS, true);
+                }
+                return ROUTE_GLASSBRIDGE;
+            }
+            case Route::GlassBridgeReset: {
+                string_view room;
+                extractJsonFields(body, {{"room", &room}});
+                uint64_t key = roomKey(room);
+                uint64_t seed = freshSeed();
+                withRoom(timers, key, [&](RoomState& state) {
+                    GlassBridgeGame::resetBridge(state, seed);
+                    journal(JournalEntry(JournalKind::BridgeReset, key, seed));
+                });
+                JsonWriter& json = begin(200);
+                json.beginObject();
+                json.text("message", "Bridge reset");
+                json.endObject();
+                publish(key, "bridgeReset", [](JsonWriter&) {});
+                return ROUTE_GLASSBRIDGE;
+            }
+            case Route::TugOfWar: {
+                string_view room, playerName, strategy;
+                int strength = 0, turn = 0, opponentStrength = 0;
+                extractJsonFields(body, {{"room", &room}, {"playerName", &playerName}, {"strength", &strength}, {"turn", &turn},
+                                         {"opponentStrength", &opponentStrength}, {"strategy", &strategy}});
+                uint64_t key = roomKey(room);
+                TugStrategy decoded = parseTugStrategy(strategy);
+                TugOfWarResult result;
+                // Pulled under the room's lock so the journal orders the room's draws
+                withRoom(timers, key, [&](RoomState& state) {
+                    Rng rng = state.nextRng();
+                    result = TugOfWarGame::processPull(rng, strength, turn, opponentStrength, decoded);
+                    JournalEntry entry(JournalKind::TugOfWar, key, roomKey(playerName));
+                    entry.a = (uint8_t)decoded;
+                    entry.x = strength;
+                    entry.y = turn;
+                    entry.z = opponentStrength;
+                    entry.result = result.playerStrength;
+                    entry.flags = result.survived ? JournalEntry::SURVIVED : 0;
+                    journal(entry);
+                });
+                writeJson(begin(200), result);
+                if (turn >= 10) {
+                    if (!result.survived) publishElimination(key, "tugofwar", playerName, result.message);
+                    recordResult(ResultGame::TugOfWar, playerName, result.playerStrength, result.survived);
+                }
+                return ROUTE_TUGOFWAR;
+            }
+            case Route::Events:
+                // Streams are opened by the event loop before a request gets here
+                writeJsonError(begin(404), "Event streams need the epoll server");
+                return ROUTE_UNKNOWN;
+            default:
+                writeJsonError(begin(200), "Unknown endpoint");
+                return ROUTE_UNKNOWN;
+        }
+    }
+    
+    // POST /batch: an array of actions, each a game endpoint's body plus the
+    // "path" it would have been posted to. They run in order, exactly as
+    // separate requests would, and the results come back as one array. An
+    // element that is not a well-formed object gets an error result and ends
+    // the batch; the actions before it have already been applied.
+    void runBatch(string_view body, HttpResponseWriter& response, LoopTimers& timers) {
+        size_t first = body.find_first_not_of(" \t\r\n");
+        if (first == string_view::npos || body[first] != '[') {
+            writeJsonError(response.begin(400), "Expected an array of actions");
+            return;
+        }
+        JsonWriter& json = response.begin(200);
+        json.beginArray();
+        uint64_t actions = 0;
+        bool wellFormed = forEachJsonObject(body, [&](string_view action) {
+            string_view path;
+            extractJsonFields(action, {{"path", &path}});
+            json.element();
+            runAction(ROUTES.lookup(path), action, timers, [&](int) -> JsonWriter& { return json; });
+            actions++;
+        });
+        if (!wellFormed) {
+            json.element();
+            writeJsonError(json, "Bad request");
+        }
+        json.endArray();
+        Metrics::local().batchActions.add(actions);
+    }
+    
+    // GET or HEAD for a path that is neither a route nor a frontend file.
+    // Returns the body length not in the buffer, as writeStaticFile does:
+    // HEAD gets the 404's headers without its body.
+    size_t writeNotFound(const HttpRequest& request, HttpResponseWriter& response) {
+        JsonWriter& json = response.begin(404);
+        size_t bodyStart = response.buffer().size();
+        writeJsonError(json, "Not found");
+        if (METHODS.lookup(request.method) != Method::Head) return 0;
+        size_t length = response.buffer().size() - bodyStart;
+        response.buffer().resize(bodyStart);
+        return length;
+    }
+    
+    // GET or HEAD for a frontend file. Returns the body length not in the
+    // buffer, for Content-Length; *file, when given, receives the part to
+    // sendfile after it.
+    size_t writeStaticFile(const HttpRequest& request, const StaticFile& staticFile, HttpResponseWriter& response,
+                           FileSend* file) {
+        const StaticBody& body = staticFile.pick(request.acceptEncoding);
+        if (!request.ifNoneMatch.empty() && StaticFiles::etagMatches(request.ifNoneMatch, body.etag)) {
+            Metrics::local().staticNotModified.add();
+            response.begin(304, staticFile.contentType, body.headers);
+            return body.size; // the length a 200 would have had; no body follows
+        }
+        response.begin(200, staticFile.contentType, body.headers);
+        if (METHODS.lookup(request.method) == Method::Head) return body.size;
+        if (body.fd < 0) {
+            response.buffer().append(body.bytes);
+            return 0;
+        }
+#ifdef SQUID_HAVE_SENDFILE
+        if (file) {
+            file->fd = body.fd;
+            file->offset = 0;
+            file->remaining = body.size;
+            return body.size;
+        }
+        // No event loop to send it: read it into the buffer
+        string& out = response.buffer();
+        size_t start = out.size();
+        out.resize(start + body.size);
+        size_t done = 0;
+        while (done < body.size) {
+            ssize_t n = pread(body.fd, &out[start + done], body.size - done, (off_t)done);
+            if (n <= 0) break;
+            done += (size_t)n;
+        }
+        out.resize(start + done);
+#else
+        (void)file;
+#endif
+        return 0;
+    }
+    
+    // Route a parsed request to its game handler and serialize the result.
+    // file is where a static file's sendfile body is handed back, if the
+    // caller can send one.
+    void processRequest(const HttpRequest& request, HttpResponseWriter& response, LoopTimers& timers,
+                        FileSend* file = nullptr) {
+        Method method = METHODS.lookup(request.method);
+        // Handle OPTIONS request for CORS
+        if (method == Method::Options) {
+            response.begin(200);
+            response.end();
+            return;
+        }
+        
+        string_view path = request.path;
+        string_view body = request.body;
+        Route target = routeFor(path);
+        
+        if (target == Route::Metrics) {
+            response.begin(200, "text/plain; version=0.0.4");
+            Metrics::instance().writePrometheus(response.buffer());
+            response.end();
+            return;
+        }
+        
+        auto started = chrono::steady_clock::now();
+        int route = ROUTE_UNKNOWN;
+        size_t following = 0;
+        const StaticFile* staticFile = nullptr;
+        bool notFound = false; // a GET for a file the frontend does not have
+        if (target == Route::Unknown && (method == Method::Get || method == Method::Head)) {
+            staticFile = staticFiles.find(targetPath(path));
+            notFound = !staticFile && staticFiles.size() > 0;
+        }
+        
+        if (target == Route::Batch) {
+            route = ROUTE_BATCH;
+            runBatch(body, response, timers);
+        } else if (target == Route::Leaderboard) {
+            route = ROUTE_LEADERBOARD;
+            writeLeaderboard(path, response);
+        } else if (staticFile) {
+            route = ROUTE_STATIC;
+            following = writeStaticFile(request, *staticFile, response, file);
+        } else if (notFound) {
+            following = writeNotFound(request, response);
+        } else {
+            route = runAction(target, body, timers, [&](int status) -> JsonWriter& { return response.begin(status); });
+        }
+        response.end(following);
+        
+        uint64_t latencyNs = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count();
+        Metrics::local().latency[route].record(latencyNs);
+        SQUID_LOG(LogLevel::Info, "request", path, response.status(), (uint32_t)(latencyNs / 1000));
     }
     
     ~SimpleHttpServer() {
+#ifdef SQUID_HAVE_EPOLL
+        workers.clear(); // workers close their own listeners
+#else
         if (serverSocket != INVALID_SOCKET) {
             closesocket(serverSocket);
         }
+#endif
 #ifdef _WIN32
         WSACleanup();
 #endif
@@ -416,19 +1880,94 @@ public:
 };
 
 // ================= Main =================
-int main() {
-    srand(static_cast<unsigned int>(time(0)));
+// Usage: backend [--port=N] [--threads=N] [--max-rooms=N] [--room-ttl=SECONDS]
+//                [--results=PATH] [--journal=PATH] [--snapshot-interval=SECONDS]
+//                [--static=DIR] [--io=auto|uring|epoll|blocking]
+//                [--backlog=N] [--max-connections=N] [--rate-limit=N] [--rate-burst=N (at most 4095)]
+//                [--shed-after-ms=N] [--log-level=debug|info|warn|error|off]
+int main(int argc, char* argv[]) {
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN); // a client hanging up mid-write must not kill the server
+#endif
+    
+    ServerConfig config;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--port=", 0) == 0) {
+            config.port = atoi(arg.c_str() + 7);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            config.workers = atoi(arg.c_str() + 10);
+        } else if (arg.rfind("--max-rooms=", 0) == 0) {
+            config.maxRooms = strtoul(arg.c_str() + 12, nullptr, 10);
+        } else if (arg.rfind("--room-ttl=", 0) == 0) {
+            config.roomTtlSec = atoi(arg.c_str() + 11);
+        } else if (arg.rfind("--results=", 0) == 0) {
+            config.resultsPath = arg.substr(10);
+        } else if (arg.rfind("--journal=", 0) == 0) {
+            config.journalPath = arg.substr(10);
+        } else if (arg.rfind("--snapshot-interval=", 0) == 0) {
+            config.snapshotSec = atoi(arg.c_str() + 20);
+        } else if (arg.rfind("--static=", 0) == 0) {
+            config.staticRoot = arg.substr(9);
+        } else if (arg.rfind("--backlog=", 0) == 0) {
+            config.backlog = atoi(arg.c_str() + 10);
+        } else if (arg.rfind("--max-connections=", 0) == 0) {
+            config.maxConnections = atoi(arg.c_str() + 18);
+        } else if (arg.rfind("--rate-limit=", 0) == 0) {
+            config.rateLimit = (uint32_t)strtoul(arg.c_str() + 13, nullptr, 10);
+        } else if (arg.rfind("--rate-burst=", 0) == 0) {
+            unsigned long burst = strtoul(arg.c_str() + 13, nullptr, 10);
+            if (burst > RateLimiter::MAX_BURST) {
+                cerr << "--rate-burst must be at most " << RateLimiter::MAX_BURST << endl;
+                return 1;
+            }
+            config.rateBurst = (uint32_t)burst;
+        } else if (arg.rfind("--shed-after-ms=", 0) == 0) {
+            config.shedAfterMs = atoi(arg.c_str() + 16);
+        } else if (arg.rfind("--io=", 0) == 0) {
+            string io = arg.substr(5);
+            if (io == "auto") config.io = IoBackend::Auto;
+            else if (io == "uring") config.io = IoBackend::Uring;
+            else if (io == "epoll") config.io = IoBackend::Epoll;
+            else if (io == "blocking") config.io = IoBackend::Blocking;
+            else {
+                cerr << "Unknown I/O backend: " << io << endl;
+                return 1;
+            }
+        } else if (arg.rfind("--log-level=", 0) == 0) {
+            LogLevel level;
+            if (!Logger::parseLevel(arg.substr(12), level)) {
+                cerr << "Unknown log level: " << arg.substr(12) << endl;
+                return 1;
+            }
+            Logger::instance().setLevel(level);
+        } else {
+            cerr << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
     
-    SimpleHttpServer server(8080);
+    if (!config.resultsPath.empty()) {
+        string error;
+        if (!ResultsStore::instance().open(config.resultsPath, error)) {
+            cerr << "Cannot open results log " << error << endl;
+            return 1;
+        }
+    }
+    
+    SimpleHttpServer server(config);
     
     if (!server.initialize()) {
         cerr << "Failed to initialize server" << endl;
         return 1;
     }
-    
+        
     cout << "Waiting for connections..." << endl;
     cout << "Press Ctrl+C to stop server" << endl << endl;
     
+    // From here on all output goes through the background log writer
+    Logger::instance().start(stdout);
+    
     server.run();
     
     return 0;
@@ -0,0 +1,256 @@
+// Microbenchmarks for the game handlers and the request/response JSON path.
+//
+// Each case runs in isolation and reports ns/op, heap allocations/op and,
+// where the kernel allows perf_event_open (Linux, perf_event_paranoid <= 2,
+// not blocked by a container), instructions/op and cycles/op.
+//
+// parseJsonField, parseJsonInt and createJsonResponse no longer exist in the
+// server: request fields are read by extractJsonFields (json.h) and responses
+// are written by writeJson into the connection buffer (http_response.h,
+// games.h). Those current equivalents are measured here, next to the original
+// createJsonResponse kept verbatim as the baseline; json_bench.cpp compares
+// the original parse helpers in more detail.
+//
+// Build (from backend/): g++ -std=c++17 -O2 bench/game_bench.cpp games.cpp -o game_bench
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "../games.h"
+#include "../json.h"
+#include "../timer_wheel.h"
+
+using namespace std;
+
+// ---- Allocation counting (the benchmark is single-threaded) ----
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ---- Hardware counters ----
+
+class HardwareCounter {
+private:
+    int fd = -1;
+
+public:
+    explicit HardwareCounter(uint64_t config) {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+        (void)config;
+#endif
+    }
+    ~HardwareCounter() {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    bool available() const { return fd >= 0; }
+
+    void start() {
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    uint64_t stop() {
+        uint64_t value = 0;
+#ifdef __linux__
+        if (fd < 0) return 0;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &value, sizeof(value)) != (ssize_t)sizeof(value)) value = 0;
+#endif
+        return value;
+    }
+};
+
+#ifdef __linux__
+static HardwareCounter instructions(PERF_COUNT_HW_INSTRUCTIONS);
+static HardwareCounter cycles(PERF_COUNT_HW_CPU_CYCLES);
+#else
+static HardwareCounter instructions(0);
+static HardwareCounter cycles(0);
+#endif
+
+// Keep the optimizer from discarding benchmark results
+static volatile size_t sink;
+
+template <typename F>
+static void bench(const char* label, long iterations, F&& body) {
+    for (long i = 0; i < iterations / 10; i++) body(); // warm up
+
+    size_t allocsBefore = allocations;
+    instructions.start();
+    cycles.start();
+    auto t0 = chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) body();
+    auto t1 = chrono::steady_clock::now();
+    uint64_t cyc = cycles.stop();
+    uint64_t ins = instructions.stop();
+    size_t allocs = allocations - allocsBefore;
+
+    char line[160];
+    double ns = chrono::duration<double, nano>(t1 - t0).count() / iterations;
+    int n = snprintf(line, sizeof(line), "  %-44s %8.1f ns/op %7.2f allocs/op", label, ns, (double)allocs / iterations);
+    if (instructions.available()) {
+        snprintf(line + n, sizeof(line) - n, " %8.0f ins/op %8.0f cycles/op", (double)ins / iterations,
+                 (double)cyc / iterations);
+    }
+    cout << line << endl;
+}
+
+// ---- Original response builder from backend.cpp, kept verbatim as the baseline ----
+string createJsonResponse(const map<string, string>& data) {
+    stringstream json;
+    json << "{";
+    bool first = true;
+    for (const auto& pair : data) {
+        if (!first) json << ",";
+        json << "\"" << pair.first << "\":\"" << pair.second << "\"";
+        first = false;
+    }
+    json << "}";
+    return json.str();
+}
+
+// The strategy decoding processPull used to do inline, kept as a baseline
+static int strategyNumberOriginal(string_view strategy) {
+    int strategyNum = 2; // default
+    if (strategy == "hard" || strategy == "1") {
+        strategyNum = 1;
+    } else if (strategy == "steady" || strategy == "2") {
+        strategyNum = 2;
+    } else if (strategy == "three-steps" || strategy == "3") {
+        strategyNum = 3;
+    } else if (strategy == "hold" || strategy == "4") {
+        strategyNum = 4;
+    }
+    return strategyNum;
+}
+
+int main(int argc, char* argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : 2000000;
+    if (!instructions.available()) cout << "(hardware counters unavailable; reporting time and allocations only)" << endl;
+
+    Rng rng(12345);
+    RoomState room;
+    room.seed = 0x5EED;
+
+    cout << "Game handlers" << endl;
+    long counter = 0;
+    bench("RedLightGreenLightGame::processAction", iterations, [&]() {
+        RedLightResult r = RedLightGreenLightGame::processAction(rng.coin() ? LIGHT_GREEN : LIGHT_RED,
+                                                                 parseRedLightAction((counter++ & 1) ? "move" : "stay"), 7);
+        sink = r.position + r.survived;
+    });
+    bench("GlassBridgeGame::processChoice", iterations, [&]() {
+        int step = (int)(counter++ % BRIDGE_STEPS);
+        if (step == 0) room.brokenPanels = 0; // walk the same bridge again
+        GlassBridgeResult r = GlassBridgeGame::processChoice(room, parsePanel((counter & 2) ? "left" : "right"), step);
+        sink = r.survived;
+    });
+    static const string_view strategies[] = {"hard", "steady", "three-steps", "hold"};
+    bench("TugOfWarGame::processPull", iterations, [&]() {
+        int turn = (int)(counter++ % 10) + 1;
+        TugOfWarResult r = TugOfWarGame::processPull(rng, 40, turn, 45, parseTugStrategy(strategies[counter & 3]));
+        sink = r.playerStrength + r.survived;
+    });
+
+    cout << "Vocabulary decoding (replaces string compare chains)" << endl;
+    static const string_view words[] = {"hard", "steady", "three-steps", "hold", "4", "2", "bogus", "1"};
+    bench("strategy compare chain (original)", iterations, [&]() {
+        sink = strategyNumberOriginal(words[counter++ & 7]);
+    });
+    bench("parseTugStrategy (perfect hash)", iterations, [&]() {
+        sink = (int)parseTugStrategy(words[counter++ & 7]);
+    });
+
+    cout << "Event loop timers (200k pending)" << endl;
+    struct Payload {
+        uint64_t key;
+    };
+    TimerWheel<Payload> wheel;
+    for (uint32_t i = 0; i < 200000; i++) wheel.schedule(1000 + i % 60000, Payload{i});
+    bench("TimerWheel::schedule + cancel", iterations, [&]() {
+        TimerId id = wheel.schedule(1000 + (counter++ & 65535), Payload{0});
+        sink = wheel.cancel(id);
+    });
+    auto wheelTime = chrono::steady_clock::now();
+    bench("TimerWheel::advance 10 ms (~33 fire, re-arm)", iterations / 10, [&]() {
+        wheel.schedule(1, Payload{1});
+        wheelTime += chrono::milliseconds(10);
+        wheel.advance(wheelTime, [&](const Payload& p) { sink = p.key; wheel.schedule(20000, p); });
+    });
+
+    cout << "Request parsing (replaces parseJsonField/parseJsonInt)" << endl;
+    const string request =
+        "{\"room\":\"room-17\",\"playerName\":\"Player 456\",\"strength\":42,\"turn\":7,\"opponentStrength\":35,\"strategy\":\"hard\"}";
+    bench("extractJsonFields, /tugofwar body", iterations, [&]() {
+        string_view room, playerName, strategy;
+        int strength = 0, turn = 0, opponentStrength = 0;
+        extractJsonFields(request, {{"room", &room}, {"playerName", &playerName}, {"strength", &strength}, {"turn", &turn},
+                                    {"opponentStrength", &opponentStrength}, {"strategy", &strategy}});
+        sink = room.size() + playerName.size() + strength + turn + opponentStrength + strategy.size();
+    });
+
+    cout << "Response serialization (replaces createJsonResponse)" << endl;
+    TugOfWarResult result = TugOfWarGame::processPull(rng, 40, 3, 45, TugStrategy::Steady);
+    bench("createJsonResponse (original), body only", iterations, [&]() {
+        map<string, string> data;
+        data["message"] = string(result.message) + " Current advantage: " + to_string(result.advantage);
+        data["playerStrength"] = to_string(result.playerStrength);
+        data["opponentStrength"] = to_string(result.opponentStrength);
+        data["pullStrength"] = to_string(result.pullStrength);
+        data["staminaCost"] = to_string(result.staminaCost);
+        data["survived"] = result.survived ? "true" : "false";
+        sink = createJsonResponse(data).size();
+    });
+    string out;
+    bench("writeJson, body only", iterations, [&]() {
+        out.clear();
+        JsonWriter json(out);
+        writeJson(json, result);
+        sink = out.size();
+    });
+    bench("HttpResponseWriter + writeJson, full response", iterations, [&]() {
+        out.clear();
+        HttpResponseWriter response(out, true, 15);
+        writeJson(response.begin(200), result);
+        response.end();
+        sink = out.size();
+    });
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Microbenchmark: single-pass extractJsonFields vs the original
+// parseJsonField / parseJsonInt helpers on the /tugofwar request body.
+//
+// Build (from backend/): g++ -std=c++17 -O2 bench/json_bench.cpp -o json_bench
+// Add -mavx2 to exercise the AVX2 string scan.
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "../json.h"
+
+using namespace std;
+
+// ---- Original helpers from backend.cpp, kept verbatim as the baseline ----
+string parseJsonField(const string& json, const string& field) {
+    size_t pos = json.find("\"" + field + "\"");
+    if (pos == string::npos) return "";
+    
+    pos = json.find(":", pos);
+    if (pos == string::npos) return "";
+    
+    pos = json.find("\"", pos);
+    if (pos == string::npos) return "";
+    
+    size_t end = json.find("\"", pos + 1);
+    if (end == string::npos) return "";
+    
+    return json.substr(pos + 1, end - pos - 1);
+}
+
+int parseJsonInt(const string& json, const string& field) {
+    size_t pos = json.find("\"" + field + "\"");
+    if (pos == string::npos) return 0;
+    
+    pos = json.find(":", pos);
+    if (pos == string::npos) return 0;
+    
+    // Skip whitespace and quotes
+    while (pos < json.length() && (json[pos] == ':' || json[pos] == ' ' || json[pos] == '"')) pos++;
+    
+    string numStr;
+    while (pos < json.length() && (isdigit(json[pos]) || json[pos] == '-')) {
+        numStr += json[pos++];
+    }
+    
+    return numStr.empty() ? 0 : atoi(numStr.c_str());
+}
+
+// Keep the optimizer from discarding benchmark results
+static volatile size_t sink;
+
+template <typename F>
+static double nsPerOp(const char* label, long iterations, F&& body) {
+    for (long i = 0; i < iterations / 10; i++) body(); // warm up
+    auto t0 = chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) body();
+    auto t1 = chrono::steady_clock::now();
+    double ns = chrono::duration<double, nano>(t1 - t0).count() / iterations;
+    cout << "  " << label << ": " << ns << " ns/op" << endl;
+    return ns;
+}
+
+static void runCase(const char* name, const string& body, long iterations) {
+    cout << name << " (" << body.size() << " bytes)" << endl;
+
+    double before = nsPerOp("parseJsonField/Int x5", iterations, [&]() {
+        string playerName = parseJsonField(body, "playerName");
+        int strength = parseJsonInt(body, "strength");
+        int turn = parseJsonInt(body, "turn");
+        int opponentStrength = parseJsonInt(body, "opponentStrength");
+        string strategy = parseJsonField(body, "strategy");
+        sink = playerName.size() + strength + turn + opponentStrength + strategy.size();
+    });
+
+    double after = nsPerOp("extractJsonFields    ", iterations, [&]() {
+        string_view playerName, strategy;
+        int strength = 0, turn = 0, opponentStrength = 0;
+        extractJsonFields(body, {{"playerName", &playerName}, {"strength", &strength}, {"turn", &turn},
+                                 {"opponentStrength", &opponentStrength}, {"strategy", &strategy}});
+        sink = playerName.size() + strength + turn + opponentStrength + strategy.size();
+    });
+
+    cout << "  speedup: " << before / after << "x" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : 2000000;
+
+    // Sanity check: both paths agree on a well-formed body
+    const string sample = "{\"playerName\":\"Gi-hun\",\"strength\":42,\"turn\":7,\"opponentStrength\":-3,\"strategy\":\"hard\"}";
+    string_view name, strategy;
+    int strength = 0, turn = 0, opponent = 0;
+    extractJsonFields(sample, {{"playerName", &name}, {"strength", &strength}, {"turn", &turn},
+                               {"opponentStrength", &opponent}, {"strategy", &strategy}});
+    if (name != parseJsonField(sample, "playerName") || strategy != parseJsonField(sample, "strategy") ||
+        strength != parseJsonInt(sample, "strength") || turn != parseJsonInt(sample, "turn") ||
+        opponent != parseJsonInt(sample, "opponentStrength")) {
+        cerr << "Mismatch between extractJsonFields and the original helpers" << endl;
+        return 1;
+    }
+
+    runCase("compact /tugofwar body", sample, iterations);
+    runCase("pretty-printed body",
+            "{\n  \"playerName\": \"Player 456\",\n  \"strength\": 42,\n  \"turn\": 7,\n"
+            "  \"opponentStrength\": 35,\n  \"strategy\": \"three-steps\"\n}",
+            iterations);
+    runCase("long player name",
+            "{\"playerName\":\"" + string(200, 'x') + "\",\"strength\":42,\"turn\":7,\"opponentStrength\":35,\"strategy\":\"steady\"}",
+            iterations);
+    return 0;
+}
@@ -0,0 +1,444 @@
+// HTTP load generator for the backend (Linux).
+//
+// Each thread drives its share of the connections from its own epoll loop and
+// replays a weighted mix of /redlight, /glassbridge and /tugofwar bodies,
+// spread over a configurable number of rooms. One request is in flight per
+// connection at a time.
+//
+// Two modes:
+//   closed loop (--rate=0, the default): every connection sends its next
+//     request as soon as the previous response arrives. This measures peak
+//     throughput; its latencies describe a client that backs off.
+//   open loop (--rate=N): requests are scheduled at N/s in total regardless
+//     of how fast responses come back. Latency runs from the *scheduled* send
+//     time, so time a request spends waiting for a free connection counts
+//     against the server and stalls are not hidden (no coordinated omission).
+//     Requests still unanswered when the run ends are recorded with the time
+//     they have waited so far.
+//
+// Build (from backend/): g++ -std=c++17 -O2 -pthread bench/loadgen.cpp -o loadgen
+// Example: ./loadgen --connections=256 --threads=4 --duration=20 --rate=50000
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../metrics.h"
+#include "../rng.h"
+
+using namespace std;
+
+struct LoadConfig {
+    string host = "127.0.0.1";
+    int port = 8080;
+    int connections = 64;
+    int threads = 4;
+    int durationSec = 10;
+    int warmupSec = 2;
+    double rate = 0; // requests per second across all threads; 0 = closed loop
+    bool shortLived = false;
+    int rooms = 100;
+    int mix[3] = {50, 30, 20}; // redlight, glassbridge, tugofwar weights
+    int batch = 1;             // actions per request; above 1 they go to /batch
+};
+
+static const char* const ROUTE_PATHS[3] = {"/redlight", "/glassbridge", "/tugofwar"};
+
+static uint64_t nowNs() {
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---- Request bodies ----
+
+static int pickRoute(Rng& rng, const LoadConfig& config) {
+    int total = config.mix[0] + config.mix[1] + config.mix[2];
+    int roll = (int)rng.below((uint32_t)total);
+    if (roll < config.mix[0]) return 0;
+    if (roll < config.mix[0] + config.mix[1]) return 1;
+    return 2;
+}
+
+// One action's JSON object; /batch elements also name the endpoint
+static void appendBody(string& body, Rng& rng, const LoadConfig& config, int route, bool withPath) {
+    static const char* const strategies[] = {"hard", "steady", "three-steps", "hold"};
+    body += '{';
+    if (withPath) body += string("\"path\":\"") + ROUTE_PATHS[route] + "\",";
+    body += "\"room\":\"room-" + to_string(rng.below((uint32_t)config.rooms)) + "\",\"playerName\":\"Player " +
+            to_string(rng.between(1, 456)) + "\",";
+    if (route == 0) {
+        body += string("\"action\":\"") + (rng.coin() ? "move" : "stay") + "\",\"position\":" + to_string(rng.between(0, 99));
+    } else if (route == 1) {
+        body += string("\"choice\":\"") + (rng.coin() ? "left" : "right") + "\",\"step\":" + to_string(rng.below(18));
+    } else {
+        body += "\"strength\":" + to_string(rng.between(20, 100)) + ",\"turn\":" + to_string(rng.between(1, 10)) +
+                ",\"opponentStrength\":" + to_string(rng.between(20, 100)) + ",\"strategy\":\"" +
+                strategies[rng.below(4)] + "\"";
+    }
+    body += '}';
+}
+
+// A batch is filed under its first action's route
+static void appendRequest(string& out, Rng& rng, const LoadConfig& config, int route) {
+    string body;
+    if (config.batch > 1) {
+        body += '[';
+        for (int i = 0; i < config.batch; i++) {
+            if (i) body += ',';
+            appendBody(body, rng, config, i ? pickRoute(rng, config) : route, true);
+        }
+        body += ']';
+    } else {
+        appendBody(body, rng, config, route, false);
+    }
+
+    out.append("POST ").append(config.batch > 1 ? "/batch" : ROUTE_PATHS[route]).append(" HTTP/1.1\r\nHost: ").append(config.host);
+    out.append("\r\nContent-Type: application/json\r\nContent-Length: ").append(to_string(body.size()));
+    out.append(config.shortLived ? "\r\nConnection: close\r\n\r\n" : "\r\n\r\n");
+    out += body;
+}
+
+// ---- Per-thread driver ----
+
+struct ThreadResult {
+    LatencyHistogram latency[3];
+    uint64_t completed = 0;
+    uint64_t non200 = 0;
+    uint64_t socketErrors = 0;
+    uint64_t unanswered = 0;
+};
+
+class LoadThread {
+private:
+    struct Conn {
+        int fd = -1;
+        bool connected = false;
+        bool busy = false;
+        int route = 0;
+        uint64_t intendedNs = 0;
+        string out;
+        size_t sent = 0;
+        string in;
+    };
+
+    const LoadConfig& config;
+    ThreadResult& result;
+    sockaddr_in address;
+    int epfd;
+    Rng rng;
+    vector<Conn> conns;
+    deque<uint64_t> scheduled; // open loop: intended send times not yet on a connection
+    uint64_t measureFrom;
+
+    void open(int index) {
+        Conn& c = conns[index];
+        c = Conn();
+        c.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int one = 1;
+        setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(c.fd, (sockaddr*)&address, sizeof(address)) < 0 && errno != EINPROGRESS) {
+            result.socketErrors++;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        ev.data.u32 = (uint32_t)index;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, c.fd, &ev);
+    }
+
+    // Drop the connection; its request (if any) goes back on the schedule
+    void reopen(int index) {
+        Conn& c = conns[index];
+        if (c.busy && config.rate > 0) scheduled.push_front(c.intendedNs);
+        close(c.fd);
+        open(index);
+    }
+
+    void start(int index, uint64_t intendedNs) {
+        Conn& c = conns[index];
+        c.busy = true;
+        c.intendedNs = intendedNs;
+        c.route = pickRoute(rng, config);
+        c.out.clear();
+        c.sent = 0;
+        c.in.clear();
+        appendRequest(c.out, rng, config, c.route);
+        if (c.connected) write(index);
+    }
+
+    void write(int index) {
+        Conn& c = conns[index];
+        while (c.sent < c.out.size()) {
+            ssize_t n = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                c.sent += (size_t)n;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;
+            } else {
+                result.socketErrors++;
+                reopen(index);
+                return;
+            }
+        }
+    }
+
+    // True once a full response (headers + Content-Length body) is buffered
+    static bool responseComplete(const string& in, int& status) {
+        size_t headerEnd = in.find("\r\n\r\n");
+        if (headerEnd == string::npos) return false;
+        status = in.size() > 12 ? atoi(in.c_str() + 9) : 0;
+        size_t length = 0;
+        for (size_t line = in.find("\r\n") + 2; line < headerEnd; line = in.find("\r\n", line) + 2) {
+            if (strncasecmp(in.c_str() + line, "Content-Length:", 15) == 0) length = strtoul(in.c_str() + line + 15, nullptr, 10);
+        }
+        return in.size() >= headerEnd + 4 + length;
+    }
+
+    void read(int index, uint64_t now) {
+        Conn& c = conns[index];
+        char buf[16384];
+        bool peerClosed = false;
+        while (true) {
+            ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                c.in.append(buf, (size_t)n);
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                peerClosed = true;
+                break;
+            }
+        }
+
+        int status = 0;
+        bool answered = c.busy && responseComplete(c.in, status);
+        if (answered) {
+            c.busy = false;
+            if (c.intendedNs >= measureFrom) {
+                result.latency[c.route].record(now - c.intendedNs);
+                result.completed++;
+                if (status != 200) result.non200++;
+            }
+        }
+        // A close is expected right after a Connection: close response
+        if (peerClosed && !(answered && config.shortLived)) result.socketErrors++;
+        if (peerClosed || (answered && config.shortLived)) reopen(index);
+    }
+
+public:
+    LoadThread(const LoadConfig& cfg, ThreadResult& res, int connectionCount, uint64_t seed)
+        : config(cfg), result(res), rng(seed), conns((size_t)connectionCount) {
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)config.port);
+        inet_pton(AF_INET, config.host.c_str(), &address.sin_addr);
+        epfd = epoll_create1(0);
+    }
+
+    ~LoadThread() {
+        for (Conn& c : conns) {
+            if (c.fd >= 0) close(c.fd);
+        }
+        close(epfd);
+    }
+
+    void run(uint64_t startNs) {
+        measureFrom = startNs + (uint64_t)config.warmupSec * 1000000000ull;
+        uint64_t endNs = measureFrom + (uint64_t)config.durationSec * 1000000000ull;
+        double perThreadRate = config.rate / config.threads;
+        uint64_t intervalNs = config.rate > 0 ? (uint64_t)(1e9 / perThreadRate) : 0;
+        uint64_t nextSend = startNs;
+
+        for (size_t i = 0; i < conns.size(); i++) open((int)i);
+
+        epoll_event events[256];
+        while (true) {
+            uint64_t now = nowNs();
+            if (now >= endNs) break;
+
+            if (intervalNs) {
+                for (; nextSend <= now; nextSend += intervalNs) scheduled.push_back(nextSend);
+            }
+            for (size_t i = 0; i < conns.size(); i++) {
+                if (conns[i].busy) continue;
+                if (intervalNs) {
+                    if (scheduled.empty()) break;
+                    uint64_t intended = scheduled.front();
+                    scheduled.pop_front();
+                    start((int)i, intended);
+                } else {
+                    start((int)i, now);
+                }
+            }
+
+            int timeoutMs = 1;
+            if (intervalNs && nextSend > now) timeoutMs = (int)((nextSend - now) / 1000000);
+            int n = epoll_wait(epfd, events, 256, timeoutMs);
+            now = nowNs();
+            for (int e = 0; e < n; e++) {
+                int index = (int)events[e].data.u32;
+                Conn& c = conns[index];
+                if (events[e].events & EPOLLOUT) {
+                    if (!c.connected) {
+                        int err = 0;
+                        socklen_t len = sizeof(err);
+                        getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                        if (err) {
+                            result.socketErrors++;
+                            reopen(index);
+                            continue;
+                        }
+                        c.connected = true;
+                    }
+                    if (c.busy) write(index);
+                }
+                if (events[e].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) read(index, now);
+            }
+        }
+
+        // Whatever has not been answered by now has waited at least this long
+        uint64_t end = nowNs();
+        for (Conn& c : conns) {
+            if (c.busy && c.intendedNs >= measureFrom) {
+                result.latency[c.route].record(end - c.intendedNs);
+                result.unanswered++;
+            }
+        }
+        for (uint64_t intended : scheduled) {
+            if (intended < measureFrom) continue;
+            result.latency[0].record(end - intended); // never sent, so it has no route; file it anywhere
+            result.unanswered++;
+        }
+    }
+};
+
+// ---- Reporting ----
+
+static uint64_t quantile(const vector<uint64_t>& counts, uint64_t total, double q) {
+    uint64_t rank = (uint64_t)(q * (double)total);
+    if (rank >= total) rank = total - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+        seen += counts[b];
+        if (seen > rank) return LatencyHistogram::bucketUpperBound(b);
+    }
+    return LatencyHistogram::bucketUpperBound(LatencyHistogram::BUCKETS - 1);
+}
+
+static void printRow(const char* label, const vector<uint64_t>& counts, uint64_t total, double seconds) {
+    char line[160];
+    if (total == 0) {
+        snprintf(line, sizeof(line), "  %-12s %10s\n", label, "-");
+    } else {
+        snprintf(line, sizeof(line), "  %-12s %10.0f %10.1f %10.1f %10.1f %10.1f\n", label, total / seconds,
+                 quantile(counts, total, 0.5) / 1e3, quantile(counts, total, 0.99) / 1e3,
+                 quantile(counts, total, 0.999) / 1e3, quantile(counts, total, 1.0) / 1e3);
+    }
+    cout << line;
+}
+
+static bool parseMix(const string& text, int mix[3]) {
+    return sscanf(text.c_str(), "%d,%d,%d", &mix[0], &mix[1], &mix[2]) == 3 && mix[0] >= 0 && mix[1] >= 0 &&
+           mix[2] >= 0 && mix[0] + mix[1] + mix[2] > 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Usage: loadgen [--host=IP] [--port=N] [--connections=N] [--threads=N] [--duration=SECONDS]
+    //                [--warmup=SECONDS] [--rate=REQ_PER_SEC] [--close] [--rooms=N] [--mix=RL,GB,TW]
+    //                [--batch=ACTIONS_PER_REQUEST]
+    LoadConfig config;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        string key = arg.substr(0, eq);
+        string value = eq == string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--host") config.host = value;
+        else if (key == "--port") config.port = atoi(value.c_str());
+        else if (key == "--connections") config.connections = atoi(value.c_str());
+        else if (key == "--threads") config.threads = atoi(value.c_str());
+        else if (key == "--duration") config.durationSec = atoi(value.c_str());
+        else if (key == "--warmup") config.warmupSec = atoi(value.c_str());
+        else if (key == "--rate") config.rate = atof(value.c_str());
+        else if (key == "--close") config.shortLived = true;
+        else if (key == "--rooms") config.rooms = atoi(value.c_str());
+        else if (key == "--batch") config.batch = atoi(value.c_str());
+        else if (key == "--mix" && parseMix(value, config.mix)) continue;
+        else {
+            cerr << "Unknown or invalid option: " << arg << endl;
+            return 1;
+        }
+    }
+    if (config.threads < 1) config.threads = 1;
+    if (config.connections < config.threads) config.connections = config.threads;
+    if (config.rooms < 1) config.rooms = 1;
+    if (config.batch < 1) config.batch = 1;
+    signal(SIGPIPE, SIG_IGN);
+
+    cout << "Target http://" << config.host << ":" << config.port << ", " << config.connections << " "
+         << (config.shortLived ? "short-lived" : "keep-alive") << " connections on " << config.threads << " threads, ";
+    if (config.rate > 0) cout << "open loop at " << config.rate << " req/s";
+    else cout << "closed loop";
+    if (config.batch > 1) cout << ", " << config.batch << " actions per /batch request";
+    cout << ", " << config.warmupSec << " s warmup + " << config.durationSec << " s" << endl;
+
+    vector<ThreadResult> results((size_t)config.threads);
+    vector<thread> threads;
+    uint64_t startNs = nowNs();
+    uint64_t seed = freshSeed();
+    for (int t = 0; t < config.threads; t++) {
+        int share = config.connections / config.threads + (t < config.connections % config.threads ? 1 : 0);
+        threads.emplace_back([&, t, share]() {
+            LoadThread driver(config, results[t], share, mixSeed(seed, (uint64_t)t));
+            driver.run(startNs);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    double seconds = config.durationSec > 0 ? config.durationSec : 1;
+    uint64_t completed = 0, non200 = 0, socketErrors = 0, unanswered = 0;
+    vector<uint64_t> all(LatencyHistogram::BUCKETS);
+    uint64_t allTotal = 0;
+
+    cout << "\n  " << "route             req/s   p50 (us)   p99 (us)  p999 (us)   max (us)" << endl;
+    for (int route = 0; route < 3; route++) {
+        vector<uint64_t> counts(LatencyHistogram::BUCKETS);
+        uint64_t total = 0;
+        for (auto& r : results) {
+            for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+                uint64_t count = r.latency[route].counts[b].get();
+                counts[b] += count;
+                all[b] += count;
+                total += count;
+            }
+        }
+        allTotal += total;
+        printRow(ROUTE_PATHS[route], counts, total, seconds);
+    }
+    printRow("all", all, allTotal, seconds);
+
+    for (auto& r : results) {
+        completed += r.completed;
+        non200 += r.non200;
+        socketErrors += r.socketErrors;
+        unanswered += r.unanswered;
+    }
+    if (config.batch > 1) cout << "\n  actions/s " << (double)allTotal * config.batch / seconds << endl;
+    cout << "\n  completed " << completed << ", non-200 " << non200 << ", socket errors " << socketErrors
+         << ", unanswered at end " << unanswered << endl;
+    return non200 || socketErrors ? 2 : 0;
+}
@@ -0,0 +1,82 @@
+// Tug of War replay: scalar TugPhysics vs the batch kernel.
+//
+// Generates random tap timelines (steady tappers, bursty tappers and idle
+// gaps), replays every one with replayTug and with replayTugBatch, checks the
+// two strengths are bit-identical for every player and reports throughput.
+// Exits 1 on any mismatch.
+//
+// Build (from backend/): g++ -std=c++17 -O2 bench/tug_bench.cpp -o tug_bench
+//                   AVX2: g++ -std=c++17 -O2 -mavx2 bench/tug_bench.cpp -o tug_bench
+// Usage: tug_bench [players=20000] [seed=1]
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "../tug_physics.h"
+
+using namespace std;
+
+static const char* kernelName() {
+#if defined(SQUID_TUG_AVX2)
+    return "AVX2, 4 lanes";
+#elif defined(SQUID_TUG_SSE2)
+    return "SSE2, 2 lanes";
+#else
+    return "scalar";
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    size_t players = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+
+    Rng rng(seed);
+    TugParams params;
+    vector<uint64_t> seeds(players);
+    vector<size_t> offsets{0};
+    vector<double> taps;
+    for (size_t p = 0; p < players; p++) {
+        seeds[p] = rng();
+        double hz = rng.between(3, 14);
+        double jitter = 0.6 * rng.unit();
+        double t = 1000.0 * rng.unit(); // timelines need not start at 0
+        size_t count = rng.below(6) == 0 ? rng.below(4) : 200; // a few empty or cut-short rounds
+        for (size_t k = 0; k < count; k++) {
+            taps.push_back(t);
+            t += (1.0 + jitter * (2.0 * rng.unit() - 1.0)) / hz;
+            if (rng.unit() < 0.02) t += 0.5 * rng.unit(); // hesitation longer than the dt clamp
+        }
+        offsets.push_back(taps.size());
+    }
+
+    vector<double> scalar(players), batch(players);
+    auto t0 = chrono::steady_clock::now();
+    for (size_t p = 0; p < players; p++) {
+        scalar[p] = replayTug(seeds[p], taps.data() + offsets[p], offsets[p + 1] - offsets[p], params);
+    }
+    auto t1 = chrono::steady_clock::now();
+    replayTugBatch(seeds.data(), taps.data(), offsets.data(), players, params, batch.data());
+    auto t2 = chrono::steady_clock::now();
+
+    size_t mismatches = 0;
+    double total = 0.0;
+    for (size_t p = 0; p < players; p++) {
+        total += scalar[p];
+        if (memcmp(&scalar[p], &batch[p], sizeof(double)) != 0) {
+            if (mismatches++ < 5)
+                cerr << "player " << p << ": scalar " << scalar[p] << " batch " << batch[p] << endl;
+        }
+    }
+
+    double scalarMs = chrono::duration<double, milli>(t1 - t0).count();
+    double batchMs = chrono::duration<double, milli>(t2 - t1).count();
+    cout << players << " players, " << taps.size() << " taps, mean strength " << total / (players ? players : 1) << endl;
+    cout << "  scalar replayTug           " << scalarMs << " ms (" << players / scalarMs * 1000 << " players/s)" << endl;
+    cout << "  replayTugBatch (" << kernelName() << ") " << batchMs << " ms (" << players / batchMs * 1000
+         << " players/s)" << endl;
+    cout << (mismatches ? "MISMATCH: " : "identical: ") << players - mismatches << "/" << players << endl;
+    return mismatches ? 1 : 0;
+}
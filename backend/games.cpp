@@ -0,0 +1,211 @@
+// Game handlers; see games.h
+#include "games.h"
+
+using namespace std;
+
+void writeJson(JsonWriter& json, const RedLightResult& r) {
+    json.beginObject();
+    json.text("light", lightName(r.light));
+    json.text("message", r.message);
+    json.number("position", r.position);
+    json.flag("survived", r.survived);
+    json.endObject();
+}
+
+void writeJson(JsonWriter& json, const GlassBridgeResult& r) {
+    json.beginObject();
+    json.text("correctChoice", panelName(r.correctChoice));
+    json.text("message", r.message);
+    json.flag("survived", r.survived);
+    json.endObject();
+}
+
+void writeJson(JsonWriter& json, const TugOfWarResult& r) {
+    json.beginObject();
+    json.beginText("message");
+    json.appendEscaped(r.message);
+    if (r.showAdvantage) {
+        json.appendEscaped(" Current advantage: ");
+        json.appendNumber(r.advantage);
+    }
+    json.endText();
+    json.number("opponentStrength", r.opponentStrength);
+    json.number("playerStrength", r.playerStrength);
+    json.number("pullStrength", r.pullStrength);
+    json.number("staminaCost", r.staminaCost);
+    json.flag("survived", r.survived);
+    json.endObject();
+}
+
+void writeJsonError(JsonWriter& json, string_view message) {
+    json.beginObject();
+    json.text("error", message);
+    json.endObject();
+}
+
+// ================= Game Logic =================
+RedLightResult RedLightGreenLightGame::processAction(RoomLight light, RedLightAction action, int position) {
+    RedLightResult result;
+    result.light = light;
+    result.position = position;
+    bool isGreen = (light == LIGHT_GREEN);
+    
+    if (action == RedLightAction::Move) {
+        if (isGreen) {
+            // GREEN light - safe to move forward
+            result.position = position + 1;
+            result.message = "Ran forward safely!";
+        } else {
+            // RED light and player moved - instant death, no chance
+            result.survived = false;
+            result.message = "BANG! Moved during RED light! Shot by the doll!";
+            // Don't advance if dead
+        }
+    } else {
+        // Player stayed
+        if (isGreen) {
+            result.message = "Stayed still during GREEN light. No progress.";
+        } else {
+            result.message = "Stayed frozen during RED light. Safe!";
+        }
+    }
+    
+    return result;
+}
+
+RedLightResult RedLightGreenLightGame::timeUp(RoomLight light, int position) {
+    RedLightResult result;
+    result.light = light;
+    result.position = position;
+    result.survived = false;
+    result.message = "Time's up! The round is over.";
+    return result;
+}
+
+uint32_t RedLightGreenLightGame::lightPhaseMs(Rng& rng) {
+    // Both colors last 1-4 s, so a random moment is green about half the time
+    return (uint32_t)rng.between(1000, 4000);
+}
+
+uint32_t RedLightGreenLightGame::switchOn(RoomState& room) {
+    Rng rng = room.nextRng();
+    room.light = rng.coin() ? LIGHT_GREEN : LIGHT_RED;
+    return lightPhaseMs(rng);
+}
+
+uint32_t RedLightGreenLightGame::flipLight(RoomState& room) {
+    room.light = (room.light == LIGHT_GREEN) ? LIGHT_RED : LIGHT_GREEN;
+    Rng rng = room.nextRng();
+    return lightPhaseMs(rng);
+}
+
+void RedLightGreenLightGame::startRun(RoomState& run) {
+    if (++run.runEpoch == 0) run.runEpoch = 1;
+    run.runExpired = false;
+}
+
+GlassBridgeResult GlassBridgeGame::processChoice(RoomState& room, Panel choice, int step) {
+    int panelIndex = (int)choice;
+    Panel chosen = choice;
+    Panel other = (choice == Panel::Left) ? Panel::Right : Panel::Left;
+    
+    GlassBridgeResult result;
+    
+    // Check if panel is already known to be broken
+    if (room.isBroken(step, panelIndex)) {
+        result.survived = false;
+        result.correctChoice = other;
+        result.message = "That panel is already broken! You fall!";
+        return result;
+    }
+    
+    // Check if the other panel is broken (making this one safe)
+    int otherPanel = 1 - panelIndex;
+    if (room.isBroken(step, otherPanel)) {
+        result.survived = true;
+        result.correctChoice = chosen;
+        result.message = "Only safe option! You advance!";
+        return result;
+    }
+    
+    // Random 50/50 chance - one is tempered, one is normal
+    // Hash the room's seed with the panel so the same panel always gives
+    // the same answer for this bridge, on every thread
+    uint64_t roll = mixSeed(room.seed, (uint64_t)step * 2 + panelIndex);
+    bool isSafe = (roll % 10 < 7);
+    
+    if (isSafe) {
+        result.survived = true;
+        result.correctChoice = chosen;
+        result.message = "Tempered glass! Safe step!";
+    } else {
+        // Mark this panel as broken for future players
+        room.breakPanel(step, panelIndex);
+        result.survived = false;
+        result.correctChoice = other;
+        result.message = "Normal glass! It shatters! You fall!";
+    }
+    
+    return result;
+}
+
+void GlassBridgeGame::resetBridge(RoomState& room, uint64_t seed) {
+    room.seed = seed;
+    room.brokenPanels = 0;
+    room.draws = 0;
+}
+
+TugOfWarResult TugOfWarGame::processPull(Rng& rng, int currentStrength, int turn, int opponentStrength, TugStrategy strategy) {
+    // Strategy-based Tug of War (more realistic)
+    TugOfWarResult result;
+    int pullStrength = 0;
+    int staminaCost = 0;
+    
+    switch (strategy) {
+        case TugStrategy::Hard:
+            pullStrength = rng.between(4, 9); // 4-9
+            staminaCost = 8;
+            result.message = "Pulled hard!";
+            break;
+        case TugStrategy::Steady:
+            pullStrength = rng.between(3, 6); // 3-6
+            staminaCost = 3;
+            result.message = "Steady pull!";
+            break;
+        case TugStrategy::ThreeSteps:
+            if (rng.chance(60)) { // 60% success
+                pullStrength = rng.between(6, 13); // 6-13
+                result.message = "Three-steps worked! Big advantage!";
+            } else {
+                pullStrength = rng.between(1, 3); // 1-3
+                result.message = "Three-steps failed! Bad timing!";
+            }
+            staminaCost = 5;
+            break;
+        case TugStrategy::Hold:
+            pullStrength = rng.between(1, 2); // 1-2
+            staminaCost = -5; // Regain stamina
+            result.message = "Held position, regained stamina!";
+            break;
+    }
+    
+    int newStrength = currentStrength + pullStrength;
+    
+    // Determine if game is over (10 rounds or position extreme)
+    bool survived = false;
+    if (turn >= 10) {
+        survived = (newStrength >= opponentStrength);
+        result.message = survived ? "You won!" : "You lost!";
+    } else {
+        result.showAdvantage = true;
+        result.advantage = newStrength - opponentStrength;
+    }
+    
+    result.playerStrength = newStrength;
+    result.opponentStrength = opponentStrength;
+    result.survived = survived;
+    result.pullStrength = pullStrength;
+    result.staminaCost = staminaCost;
+    
+    return result;
+}
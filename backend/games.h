@@ -0,0 +1,128 @@
+// Game handlers
+//
+// The three games and their response layouts, compiled separately from the
+// HTTP server (games.cpp) so benchmarks and tools can link the handlers
+// without pulling in main() or any networking.
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "http_response.h"
+#include "keyword_table.h"
+#include "rng.h"
+#include "session_store.h"
+
+// ================= Vocabularies =================
+// The words requests use for actions, glass panels and pull strategies. The
+// router decodes each once through a compile-time perfect hash and the
+// handlers work on the enums.
+enum class RedLightAction : uint8_t { Stay, Move };
+enum class Panel : uint8_t { Left, Right }; // same order as RoomState's panel bits
+enum class TugStrategy : uint8_t { Hard, Steady, ThreeSteps, Hold };
+
+// Anything but "move" stays put
+inline RedLightAction parseRedLightAction(std::string_view word) {
+    static constexpr Keyword<RedLightAction> words[] = {{"move", RedLightAction::Move}, {"stay", RedLightAction::Stay}};
+    static constexpr auto table = makeKeywordTable(words, RedLightAction::Stay);
+    static_assert(table.perfect, "no collision-free seed for the Red Light actions");
+    return table.lookup(word);
+}
+
+// Anything but "left" is the right panel
+inline Panel parsePanel(std::string_view word) {
+    static constexpr Keyword<Panel> words[] = {{"left", Panel::Left}, {"right", Panel::Right}};
+    static constexpr auto table = makeKeywordTable(words, Panel::Right);
+    static_assert(table.perfect, "no collision-free seed for the panel names");
+    return table.lookup(word);
+}
+
+// By name or number (1-4); unknown words pull steadily
+inline TugStrategy parseTugStrategy(std::string_view word) {
+    static constexpr Keyword<TugStrategy> words[] = {
+        {"hard", TugStrategy::Hard},   {"1", TugStrategy::Hard},   {"steady", TugStrategy::Steady},
+        {"2", TugStrategy::Steady},    {"three-steps", TugStrategy::ThreeSteps},
+        {"3", TugStrategy::ThreeSteps}, {"hold", TugStrategy::Hold}, {"4", TugStrategy::Hold}};
+    static constexpr auto table = makeKeywordTable(words, TugStrategy::Steady);
+    static_assert(table.perfect, "no collision-free seed for the tug strategies");
+    return table.lookup(word);
+}
+
+inline std::string_view lightName(RoomLight light) {
+    static constexpr std::string_view names[] = {"OFF", "GREEN", "RED"};
+    return names[light];
+}
+
+inline std::string_view panelName(Panel panel) { return panel == Panel::Left ? "left" : "right"; }
+
+// ================= Response Layouts =================
+// Each endpoint has a fixed result shape; the handlers fill these and
+// writeJson emits the fields in the order the frontend has always received.
+struct RedLightResult {
+    RoomLight light = LIGHT_OFF;
+    std::string_view message;
+    int position = 0;
+    bool survived = true;
+};
+
+struct GlassBridgeResult {
+    Panel correctChoice = Panel::Left;
+    std::string_view message;
+    bool survived = false;
+};
+
+struct TugOfWarResult {
+    std::string_view message;
+    bool showAdvantage = false; // message is followed by " Current advantage: N"
+    int advantage = 0;
+    int playerStrength = 0;
+    int opponentStrength = 0;
+    int pullStrength = 0;
+    int staminaCost = 0;
+    bool survived = false;
+};
+
+void writeJson(JsonWriter& json, const RedLightResult& r);
+void writeJson(JsonWriter& json, const GlassBridgeResult& r);
+void writeJson(JsonWriter& json, const TugOfWarResult& r);
+void writeJsonError(JsonWriter& json, std::string_view message);
+
+// ================= Game Logic Classes =================
+// The doll's light is server state: each room's light flips on a timer in the
+// event loop, and an action is judged against the light when it arrives.
+class RedLightGreenLightGame {
+public:
+    static const int RUN_SECONDS = 20;        // a player's budget from the start of a run
+    static const int LIGHT_IDLE_SECONDS = 30; // a room's light stops after this long without requests
+
+    static RedLightResult processAction(RoomLight light, RedLightAction action, int position);
+
+    // Answer for a player whose run's deadline has passed
+    static RedLightResult timeUp(RoomLight light, int position);
+
+    // How long the light keeps its new color
+    static uint32_t lightPhaseMs(Rng& rng);
+
+    // Room state changes, shared by the server and the journal replay. Both
+    // light changes draw from the room's stream and return the new phase's
+    // length in ms.
+    static uint32_t switchOn(RoomState& room); // random first color
+    static uint32_t flipLight(RoomState& room);
+    static void startRun(RoomState& run);      // new epoch, deadline not yet passed
+};
+
+// Each room has its own bridge; the caller holds the room's lock, so checking
+// and breaking a panel cannot interleave with another player in that room.
+class GlassBridgeGame {
+public:
+    // step must be in [0, BRIDGE_STEPS)
+    static GlassBridgeResult processChoice(RoomState& room, Panel choice, int step);
+
+    // New tempered/normal layout from seed and no broken panels
+    static void resetBridge(RoomState& room, uint64_t seed);
+};
+
+class TugOfWarGame {
+public:
+    static TugOfWarResult processPull(Rng& rng, int currentStrength, int turn, int opponentStrength, TugStrategy strategy);
+};
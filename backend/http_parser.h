@@ -0,0 +1,290 @@
+// Incremental HTTP/1.1 request parser
+//
+// Parses requests straight out of a connection's receive buffer. Nothing is
+// copied: the parser remembers offsets while bytes trickle in, and only once
+// a request is complete hands back string_views into the buffer. A request
+// whose headers arrive over several reads is never rescanned from the start.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Growable receive buffer. recv() writes directly into the free tail and
+// consumed requests are dropped from the front, so one allocation is reused
+// for the lifetime of the connection.
+class ByteBuffer {
+private:
+    std::vector<char> storage;
+    size_t begin = 0;
+    size_t end = 0;
+
+public:
+    explicit ByteBuffer(size_t initialCapacity = 4096) : storage(initialCapacity) {}
+
+    // Pointer to at least minFree writable bytes at the tail
+    char* writePtr(size_t minFree) {
+        if (storage.size() - end < minFree) {
+            if (begin > 0) {
+                // Slide unread bytes to the front before growing
+                memmove(storage.data(), storage.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+            }
+            if (storage.size() - end < minFree) {
+                storage.resize(end + minFree > storage.size() * 2 ? end + minFree : storage.size() * 2);
+            }
+        }
+        return storage.data() + end;
+    }
+
+    size_t writableSize() const { return storage.size() - end; }
+    size_t capacity() const { return storage.size(); }
+    void commit(size_t n) { end += n; }
+
+    std::string_view readable() const { return std::string_view(storage.data() + begin, end - begin); }
+    size_t size() const { return end - begin; }
+    bool empty() const { return begin == end; }
+
+    void consume(size_t n) {
+        begin += n;
+        if (begin == end) begin = end = 0;
+    }
+
+    // Drop everything unread but keep the allocation
+    void clear() { begin = end = 0; }
+};
+
+// Response codings a client accepts (Accept-Encoding), as bits
+enum ContentCoding : uint8_t { CODING_GZIP = 1, CODING_BR = 2 };
+
+// A parsed request. All views point into the buffer passed to parse() and
+// stay valid until those bytes are consumed.
+struct HttpRequest {
+    std::string_view method;
+    std::string_view path;
+    std::string_view body;
+    std::string_view ifNoneMatch; // raw If-None-Match value, empty if absent
+    uint8_t acceptEncoding = 0;   // ContentCoding bits
+    bool keepAlive = true;
+    size_t length = 0; // bytes of the buffer this request occupies
+};
+
+// The path part of a request target, without any query string
+inline std::string_view targetPath(std::string_view target) {
+    return target.substr(0, target.find('?'));
+}
+
+inline int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Percent-decoded value of query parameter `name` in a request target.
+// Returns false (and leaves value empty) if the parameter is absent.
+inline bool queryParam(std::string_view target, std::string_view name, std::string& value) {
+    value.clear();
+    size_t question = target.find('?');
+    if (question == std::string_view::npos) return false;
+    std::string_view query = target.substr(question + 1);
+    while (!query.empty()) {
+        size_t amp = query.find('&');
+        std::string_view pair = query.substr(0, amp);
+        query = (amp == std::string_view::npos) ? std::string_view() : query.substr(amp + 1);
+        size_t eq = pair.find('=');
+        if (pair.substr(0, eq) != name) continue;
+        std::string_view raw = (eq == std::string_view::npos) ? std::string_view() : pair.substr(eq + 1);
+        for (size_t i = 0; i < raw.size(); i++) {
+            if (raw[i] == '+') {
+                value += ' ';
+            } else if (raw[i] == '%' && i + 2 < raw.size() && hexDigit(raw[i + 1]) >= 0 && hexDigit(raw[i + 2]) >= 0) {
+                value += (char)(hexDigit(raw[i + 1]) * 16 + hexDigit(raw[i + 2]));
+                i += 2;
+            } else {
+                value += raw[i];
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+class HttpRequestParser {
+public:
+    enum Status { Incomplete, Complete, BadRequest, TooLarge };
+
+private:
+    enum State { RequestLine, Headers, Body };
+
+    size_t maxRequestSize;
+    State state = RequestLine;
+    size_t lineStart = 0; // start of the line currently being parsed
+    size_t scanned = 0;   // no newline exists before this offset past lineStart
+
+    // Offsets relative to the start of the request; views are only formed
+    // once the request is complete because the buffer may move between reads
+    size_t methodLen = 0;
+    size_t pathStart = 0, pathLen = 0;
+    size_t bodyStart = 0;
+    size_t contentLength = 0;
+    size_t matchStart = 0, matchLen = 0; // If-None-Match value
+    uint8_t acceptEncoding = 0;
+    bool keepAlive = true;
+
+    static bool equalsIgnoreCase(std::string_view a, std::string_view lowercase) {
+        if (a.size() != lowercase.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            char c = a[i];
+            if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+            if (c != lowercase[i]) return false;
+        }
+        return true;
+    }
+
+    static bool containsIgnoreCase(std::string_view haystack, std::string_view lowercase) {
+        for (size_t i = 0; i + lowercase.size() <= haystack.size(); i++) {
+            if (equalsIgnoreCase(haystack.substr(i, lowercase.size()), lowercase)) return true;
+        }
+        return false;
+    }
+
+    static std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+        return s;
+    }
+
+    bool parseRequestLine(std::string_view line) {
+        size_t sp1 = line.find(' ');
+        if (sp1 == std::string_view::npos || sp1 == 0) return false;
+        size_t sp2 = line.find(' ', sp1 + 1);
+        if (sp2 == std::string_view::npos || sp2 == sp1 + 1) return false;
+
+        std::string_view version = trim(line.substr(sp2 + 1));
+        if (version.size() != 8 || version.compare(0, 5, "HTTP/") != 0) return false;
+
+        methodLen = sp1;
+        pathStart = sp1 + 1;
+        pathLen = sp2 - sp1 - 1;
+        // HTTP/1.1 defaults to persistent connections, HTTP/1.0 to close
+        keepAlive = version != "HTTP/1.0";
+        return true;
+    }
+
+    // A coding listed with q=0 is one the client refuses
+    static bool refused(std::string_view params) {
+        size_t q = params.find("q=");
+        if (q == std::string_view::npos) return false;
+        std::string_view value = trim(params.substr(q + 2));
+        for (char c : value) {
+            if (c != '0' && c != '.') return false;
+        }
+        return !value.empty();
+    }
+
+    static uint8_t parseCodings(std::string_view value) {
+        uint8_t codings = 0;
+        while (!value.empty()) {
+            size_t comma = value.find(',');
+            std::string_view item = value.substr(0, comma);
+            value = (comma == std::string_view::npos) ? std::string_view() : value.substr(comma + 1);
+            size_t semicolon = item.find(';');
+            std::string_view name = trim(item.substr(0, semicolon));
+            if (semicolon != std::string_view::npos && refused(item.substr(semicolon + 1))) continue;
+            if (equalsIgnoreCase(name, "gzip")) codings |= CODING_GZIP;
+            else if (equalsIgnoreCase(name, "br")) codings |= CODING_BR;
+        }
+        return codings;
+    }
+
+    // `line` lies within `buf`; values kept past this call are stored as
+    // offsets into it
+    bool parseHeader(std::string_view buf, std::string_view line) {
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) return false;
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = trim(line.substr(colon + 1));
+
+        if (equalsIgnoreCase(name, "content-length")) {
+            if (value.empty()) return false;
+            size_t n = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9') return false;
+                n = n * 10 + (size_t)(c - '0');
+                if (n > maxRequestSize) break; // rejected as TooLarge below
+            }
+            contentLength = n;
+        } else if (equalsIgnoreCase(name, "connection")) {
+            if (containsIgnoreCase(value, "close")) keepAlive = false;
+            else if (containsIgnoreCase(value, "keep-alive")) keepAlive = true;
+        } else if (equalsIgnoreCase(name, "if-none-match")) {
+            matchStart = (size_t)(value.data() - buf.data());
+            matchLen = value.size();
+        } else if (equalsIgnoreCase(name, "accept-encoding")) {
+            acceptEncoding = parseCodings(value);
+        } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+            return false; // chunked bodies are not supported; clients send Content-Length
+        }
+        return true;
+    }
+
+public:
+    explicit HttpRequestParser(size_t maxSize = 64 * 1024) : maxRequestSize(maxSize) {}
+
+    // Prepare for the next request on the same connection
+    void reset() {
+        state = RequestLine;
+        lineStart = 0;
+        scanned = 0;
+        contentLength = 0;
+        matchStart = matchLen = 0;
+        acceptEncoding = 0;
+        keepAlive = true;
+    }
+
+    // Feed the unconsumed bytes of the connection buffer (starting at the
+    // current request). Call again with the same prefix plus new bytes until
+    // Complete, then consume request.length bytes and reset().
+    Status parse(std::string_view buf, HttpRequest& request) {
+        while (state != Body) {
+            size_t newline = buf.find('\n', scanned);
+            if (newline == std::string_view::npos) {
+                scanned = buf.size();
+                return buf.size() > maxRequestSize ? TooLarge : Incomplete;
+            }
+
+            std::string_view line = buf.substr(lineStart, newline - lineStart);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            lineStart = scanned = newline + 1;
+
+            if (state == RequestLine) {
+                if (!parseRequestLine(line)) return BadRequest;
+                state = Headers;
+            } else if (line.empty()) {
+                bodyStart = scanned;
+                state = Body;
+            } else if (!parseHeader(buf, line)) {
+                return BadRequest;
+            }
+
+            if (scanned > maxRequestSize) return TooLarge;
+        }
+
+        if (contentLength > maxRequestSize || bodyStart + contentLength > maxRequestSize) return TooLarge;
+        if (buf.size() < bodyStart + contentLength) return Incomplete;
+
+        request.method = buf.substr(0, methodLen);
+        request.path = buf.substr(pathStart, pathLen);
+        request.body = buf.substr(bodyStart, contentLength);
+        request.ifNoneMatch = buf.substr(matchStart, matchLen);
+        request.acceptEncoding = acceptEncoding;
+        request.keepAlive = keepAlive;
+        request.length = bodyStart + contentLength;
+        return Complete;
+    }
+};
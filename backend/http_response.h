@@ -0,0 +1,211 @@
+// HTTP response serialization
+//
+// Responses are written straight into the connection's output buffer: status
+// line, headers and JSON body end up contiguous, so one send() covers them.
+// The buffer keeps its capacity between requests, so once it has grown to the
+// working size nothing on this path touches the heap.
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Appends one flat JSON object. Field names are string literals, so their
+// length is known at compile time and they are copied with a single append.
+// Values are always emitted as JSON strings ("3", "true"); that is the wire
+// format the frontend has always parsed.
+class JsonWriter {
+private:
+    std::string& out;
+    bool first = true;
+
+    template <size_t N>
+    void key(const char (&name)[N]) {
+        if (!first) out += ',';
+        first = false;
+        out += '"';
+        out.append(name, N - 1);
+        out.append("\":", 2);
+    }
+
+public:
+    explicit JsonWriter(std::string& buffer) : out(buffer) {}
+
+    void beginObject() {
+        out += '{';
+        first = true;
+    }
+    void endObject() {
+        out += '}';
+        first = false; // the object was a value; whatever follows needs a comma
+    }
+
+    // Arrays of objects: beginArray, then element() before each
+    // beginObject ... endObject, then endArray
+    void beginArray() {
+        out += '[';
+        first = true;
+    }
+    template <size_t N>
+    void beginArray(const char (&name)[N]) {
+        key(name);
+        beginArray();
+    }
+    void element() {
+        if (!first) out += ',';
+        first = false;
+    }
+    void endArray() {
+        out += ']';
+        first = false;
+    }
+
+    template <size_t N>
+    void text(const char (&name)[N], std::string_view value) {
+        key(name);
+        out += '"';
+        appendEscaped(value);
+        out += '"';
+    }
+
+    template <size_t N>
+    void number(const char (&name)[N], long long value) {
+        key(name);
+        out += '"';
+        appendNumber(value);
+        out += '"';
+    }
+
+    template <size_t N>
+    void flag(const char (&name)[N], bool value) {
+        key(name);
+        out.append(value ? "\"true\"" : "\"false\"");
+    }
+
+    // For values assembled from several pieces: beginText, append*, endText
+    template <size_t N>
+    void beginText(const char (&name)[N]) {
+        key(name);
+        out += '"';
+    }
+    void endText() { out += '"'; }
+
+    void appendNumber(long long value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, (size_t)(result.ptr - digits));
+    }
+
+    void appendEscaped(std::string_view value) {
+        static const char hex[] = "0123456789abcdef";
+        size_t runStart = 0;
+        for (size_t i = 0; i < value.size(); i++) {
+            unsigned char c = (unsigned char)value[i];
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            out.append(value.data() + runStart, i - runStart);
+            runStart = i + 1;
+            switch (c) {
+                case '"': out.append("\\\"", 2); break;
+                case '\\': out.append("\\\\", 2); break;
+                case '\n': out.append("\\n", 2); break;
+                case '\r': out.append("\\r", 2); break;
+                case '\t': out.append("\\t", 2); break;
+                default: {
+                    char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    out.append(esc, 6);
+                }
+            }
+        }
+        out.append(value.data() + runStart, value.size() - runStart);
+    }
+};
+
+inline const char* httpStatusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 413: return "Payload Too Large";
+        case 429: return "Too Many Requests";
+        case 503: return "Service Unavailable";
+        default: return "Error";
+    }
+}
+
+// Frames one response in the output buffer. Content-Length is written as a
+// fixed-width placeholder (padded with optional whitespace, which HTTP
+// permits) and filled in by end(), so the body never has to be staged and
+// copied behind the headers.
+class HttpResponseWriter {
+private:
+    std::string& out;
+    bool keepAlive;
+    int keepAliveTimeoutSec;
+    size_t lengthField = 0;
+    size_t bodyStart = 0;
+    int statusCode = 0;
+    JsonWriter json;
+
+    static constexpr size_t LENGTH_WIDTH = 10;
+
+public:
+    HttpResponseWriter(std::string& buffer, bool keepAliveConnection, int keepAliveTimeout)
+        : out(buffer), keepAlive(keepAliveConnection), keepAliveTimeoutSec(keepAliveTimeout), json(buffer) {}
+
+    bool keepsAlive() const { return keepAlive; }
+    std::string& buffer() { return out; } // for non-JSON bodies, between begin() and end()
+    int status() const { return statusCode; }
+
+    // Status line and headers with CORS; returns the writer for a JSON body.
+    // extraHeaders are complete "Name: value\r\n" lines.
+    JsonWriter& begin(int status, std::string_view contentType = "application/json", std::string_view extraHeaders = {}) {
+        statusCode = status;
+        out.append("HTTP/1.1 ");
+        json.appendNumber(status);
+        out += ' ';
+        out.append(httpStatusText(status));
+        out.append("\r\nContent-Type: ");
+        out.append(contentType.data(), contentType.size());
+        out.append("\r\n"
+                   "Access-Control-Allow-Origin: *\r\n"
+                   "Access-Control-Allow-Methods: POST, GET, OPTIONS\r\n"
+                   "Access-Control-Allow-Headers: Content-Type\r\n");
+        out.append(extraHeaders.data(), extraHeaders.size());
+        if (keepAlive) {
+            out.append("Connection: keep-alive\r\nKeep-Alive: timeout=");
+            json.appendNumber(keepAliveTimeoutSec);
+            out.append("\r\n");
+        } else {
+            out.append("Connection: close\r\n");
+        }
+        out.append("Content-Length:");
+        lengthField = out.size();
+        out.append(LENGTH_WIDTH, ' ');
+        out.append("\r\n\r\n");
+        bodyStart = out.size();
+        return json;
+    }
+
+    // Headers for a response that stays open and is written to as events
+    // happen (Server-Sent Events). It has no Content-Length and no end().
+    void beginStream(std::string_view contentType) {
+        statusCode = 200;
+        out.append("HTTP/1.1 200 OK\r\nContent-Type: ");
+        out.append(contentType.data(), contentType.size());
+        out.append("\r\n"
+                   "Cache-Control: no-cache\r\n"
+                   "Access-Control-Allow-Origin: *\r\n"
+                   "Connection: keep-alive\r\n\r\n");
+    }
+
+    // Patch the real body length into the placeholder. followingBytes are
+    // body bytes the caller sends after the buffer (a file, or nothing for HEAD).
+    void end(size_t followingBytes = 0) {
+        char digits[LENGTH_WIDTH];
+        auto result = std::to_chars(digits, digits + LENGTH_WIDTH, out.size() - bodyStart + followingBytes);
+        size_t len = (size_t)(result.ptr - digits);
+        out.replace(lengthField + LENGTH_WIDTH - len, len, digits, len);
+    }
+};
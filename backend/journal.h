@@ -0,0 +1,298 @@
+// Deterministic room journal
+//
+// Every change to a room is recorded as one 48-byte JournalEntry: the room
+// being created with its seed, the light switching, a player's Red Light run
+// starting or running out of time, each game action with its decoded inputs
+// and outcome, and bridge resets with their new seed. A room's randomness
+// comes only from its seed and draw counter (RoomState::nextRng), so applying
+// its entries in order to an empty RoomState rebuilds it exactly. replay.cpp
+// does that and checks every recorded outcome along the way.
+//
+// An entry takes its sequence number while the room's shard lock is held, so
+// the entries of one room are numbered in the order its changes happened.
+// Request threads push entries onto per-thread rings, with no lock and no
+// I/O. A writer thread merges the rings and appends to the file strictly in
+// sequence order, so replay reads the file front to back. An entry dropped
+// because its ring was full leaves a gap in the sequence. The writer skips a
+// gap after GAP_TIMEOUT_MS and replay reports it. An entry that turns up
+// after its gap was skipped is dropped too.
+//
+// Every snapshot interval the writer also copies the session table to
+// PATH.snap, writing a temporary file and renaming it. Each shard is stored
+// with the next sequence number at the moment it was copied. Replay can then
+// start from the snapshot and apply only the entries that came after.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "session_store.h"
+
+enum class JournalKind : uint8_t {
+    Start,       // first entry of a file; arg = Unix time in ms when it was opened
+    Created,     // arg = seed
+    LightOn,     // first request in a quiet room; a = the light drawn
+    LightFlip,   // a = the new light
+    LightOff,    // the room went quiet
+    RunStart,    // key = the player's run, arg = room key, x = new epoch
+    RunExpired,  // key = the player's run, x = epoch
+    RedLight,    // arg = player key, a = action, b = light, x = position, result = new position
+    GlassBridge, // arg = player key, a = panel, b = correct panel, x = step
+    BridgeReset, // arg = new seed
+    TugOfWar,    // arg = player key, a = strategy, x/y/z = strength/turn/opponent, result = new strength
+};
+
+struct JournalEntry {
+    enum Flags : uint8_t { SURVIVED = 1, EXPIRED = 2 }; // EXPIRED: Red Light run past its deadline
+
+    uint64_t seq = 0;
+    uint64_t key = 0;  // session record the entry applies to: a room, or a player's Red Light run
+    uint64_t arg = 0;
+    uint32_t atMs = 0; // since the journal was opened
+    JournalKind kind = JournalKind::Start;
+    uint8_t a = 0;
+    uint8_t b = 0;
+    uint8_t flags = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t z = 0;
+    int32_t result = 0;
+
+    JournalEntry() = default;
+    JournalEntry(JournalKind k, uint64_t recordKey, uint64_t argument = 0) : key(recordKey), arg(argument), kind(k) {}
+};
+static_assert(sizeof(JournalEntry) == 48, "journal entries are fixed 48-byte records");
+
+// PATH.snap: this header, then `rooms` SnapshotRoom records
+struct SnapshotHeader {
+    char magic[8] = {'S', 'Q', 'S', 'N', 'A', 'P', '1', 0};
+    uint64_t rooms = 0;
+    uint64_t marks[SessionStore::SHARD_COUNT] = {}; // per shard: first seq not reflected in its rooms
+};
+
+struct SnapshotRoom {
+    uint64_t key;
+    RoomState state;
+};
+
+class Journal {
+private:
+    static const size_t RING_SIZE = 8192;      // entries per thread, power of two
+    static const uint32_t GAP_TIMEOUT_MS = 200; // a missing entry this old was dropped
+
+    struct Ring {
+        JournalEntry entries[RING_SIZE];
+        alignas(64) std::atomic<size_t> head{0};
+        alignas(64) std::atomic<size_t> tail{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> retired{false};
+    };
+
+    struct ThreadHandle {
+        std::shared_ptr<Ring> ring;
+        ~ThreadHandle() {
+            if (ring) ring->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    alignas(64) std::atomic<uint64_t> nextSeq{1};
+    std::chrono::steady_clock::time_point opened;
+    std::mutex registryLock; // taken once per thread, never per entry
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::thread writer;
+    std::atomic<bool> running{false};
+
+    // Writer-owned
+    FILE* file = nullptr;
+    std::string path;
+    SessionStore* sessions = nullptr;
+    uint32_t snapshotMs = 0;
+    std::vector<SnapshotRoom> snapshotRooms; // one shard's copy; keeps its capacity between snapshots
+    uint64_t written = 1; // next seq to write
+    uint64_t skipped = 0; // seqs given up on
+    std::vector<JournalEntry> pending;
+
+    Ring& threadRing() {
+        thread_local ThreadHandle handle;
+        if (!handle.ring) {
+            handle.ring = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> guard(registryLock);
+            rings.push_back(handle.ring);
+        }
+        return *handle.ring;
+    }
+
+    uint32_t elapsedMs() const {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - opened).count();
+    }
+
+    // Collect whatever the rings hold into pending, in sequence order
+    void gather() {
+        std::vector<std::shared_ptr<Ring>> snapshot;
+        {
+            std::lock_guard<std::mutex> guard(registryLock);
+            snapshot = rings;
+        }
+        size_t before = pending.size();
+        for (auto& ring : snapshot) {
+            bool retired = ring->retired.load(std::memory_order_acquire);
+            size_t tail = ring->tail.load(std::memory_order_relaxed);
+            size_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++) pending.push_back(ring->entries[tail & (RING_SIZE - 1)]);
+            ring->tail.store(tail, std::memory_order_release);
+            if (retired) {
+                std::lock_guard<std::mutex> guard(registryLock);
+                for (size_t i = 0; i < rings.size(); i++) {
+                    if (rings[i] == ring) {
+                        rings.erase(rings.begin() + i);
+                        break;
+                    }
+                }
+            }
+        }
+        if (pending.size() != before) {
+            std::sort(pending.begin(), pending.end(),
+                      [](const JournalEntry& l, const JournalEntry& r) { return l.seq < r.seq; });
+        }
+    }
+
+    // Write the run of consecutive entries at the front of pending. Returns
+    // the number written; `gapSince` tracks how long the front has been stuck.
+    size_t writeReady(uint32_t& gapSince, bool force) {
+        // Entries that turn up after their gap was skipped would go into the
+        // file out of order. They were counted in `skipped` then.
+        size_t late = 0;
+        while (late < pending.size() && pending[late].seq < written) late++;
+        if (late) pending.erase(pending.begin(), pending.begin() + (ptrdiff_t)late);
+
+        size_t n = 0;
+        while (n < pending.size()) {
+            if (pending[n].seq != written) {
+                uint32_t now = elapsedMs();
+                if (!gapSince) gapSince = now ? now : 1;
+                if (!force && now - gapSince < GAP_TIMEOUT_MS) break;
+                skipped += pending[n].seq - written;
+                written = pending[n].seq;
+            }
+            gapSince = 0;
+            written++;
+            n++;
+        }
+        if (n) {
+            if (fwrite(pending.data(), sizeof(JournalEntry), n, file) != n) SQUID_LOG(LogLevel::Error, "journal write failed");
+            fflush(file);
+            pending.erase(pending.begin(), pending.begin() + (ptrdiff_t)n);
+        }
+        return n;
+    }
+
+    void writeSnapshot() {
+        std::string tmp = path + ".snap.tmp";
+        FILE* out = fopen(tmp.c_str(), "wb");
+        if (!out) {
+            SQUID_LOG(LogLevel::Error, "journal snapshot failed");
+            return;
+        }
+        SnapshotHeader header;
+        fwrite(&header, sizeof(header), 1, out); // rewritten with the counts below
+        // Each shard is only copied under its lock; the disk sees it after
+        bool ok = true;
+        sessions->forEachRoom([&](size_t shard) { header.marks[shard] = nextSeq.load(std::memory_order_relaxed); },
+                              [&](uint64_t key, const RoomState& state) { snapshotRooms.push_back(SnapshotRoom{key, state}); },
+                              [&](size_t) {
+                                  size_t n = snapshotRooms.size();
+                                  if (n && fwrite(snapshotRooms.data(), sizeof(SnapshotRoom), n, out) != n) ok = false;
+                                  header.rooms += n;
+                                  snapshotRooms.clear();
+                              });
+        fseek(out, 0, SEEK_SET);
+        ok = (fwrite(&header, sizeof(header), 1, out) == 1) && ok;
+        ok = (fclose(out) == 0) && ok;
+        if (!ok || std::rename(tmp.c_str(), (path + ".snap").c_str()) != 0) {
+            SQUID_LOG(LogLevel::Error, "journal snapshot failed");
+        }
+    }
+
+public:
+    static Journal& instance() {
+        static Journal journal;
+        return journal;
+    }
+
+    ~Journal() { stop(); }
+
+    // Start a new journal at path (an existing file is replaced) and, if
+    // snapshotSec > 0, snapshot `store` that often
+    bool open(const std::string& journalPath, SessionStore& store, int snapshotSec, std::string& error) {
+        if (running.load()) return true;
+        file = fopen(journalPath.c_str(), "wb");
+        if (!file) {
+            error = journalPath + ": " + strerror(errno);
+            return false;
+        }
+        path = journalPath;
+        sessions = &store;
+        snapshotMs = snapshotSec > 0 ? (uint32_t)snapshotSec * 1000u : 0;
+        opened = std::chrono::steady_clock::now();
+        JournalEntry start(JournalKind::Start, 0,
+                           (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::system_clock::now().time_since_epoch()).count());
+        fwrite(&start, sizeof(start), 1, file);
+        fflush(file);
+
+        running.store(true);
+        writer = std::thread([this]() {
+            uint32_t gapSince = 0;
+            uint32_t lastSnapshot = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                gather();
+                size_t n = writeReady(gapSince, false);
+                if (snapshotMs && elapsedMs() - lastSnapshot >= snapshotMs) {
+                    writeSnapshot();
+                    lastSnapshot = elapsedMs();
+                }
+                if (n == 0) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            gather();
+            writeReady(gapSince, true);
+            if (skipped) SQUID_LOG(LogLevel::Warn, "journal entries dropped");
+        });
+        return true;
+    }
+
+    void stop() {
+        if (!running.exchange(false)) return;
+        if (writer.joinable()) writer.join();
+        if (file) fclose(file);
+        file = nullptr;
+    }
+
+    bool enabled() const { return running.load(std::memory_order_relaxed); }
+
+    // Number and queue an entry. Call with the shard lock of entry.key's
+    // record held, so the room's entries are numbered in the order they
+    // happened. A full ring drops the entry; replay sees the gap.
+    void record(JournalEntry entry) {
+        entry.seq = nextSeq.fetch_add(1, std::memory_order_relaxed);
+        entry.atMs = elapsedMs();
+        Ring& ring = threadRing();
+        size_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) >= RING_SIZE) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring.entries[head & (RING_SIZE - 1)] = entry;
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+};
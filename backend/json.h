@@ -0,0 +1,282 @@
+// Single-pass JSON field extraction
+//
+// Request bodies are flat objects such as
+//   {"playerName":"Ali","action":"move","position":3}
+// (or, for /batch, an array of them). extractJsonFields walks an object once
+// and fills every field a route asks for, handing back string_views into the
+// body instead of copies. String contents are scanned with SSE2/AVX2 where the
+// compiler targets them.
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SQUID_JSON_SSE2 1
+#endif
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+// Where to store one requested field. String fields receive the raw text
+// between the quotes (escape sequences are left as-is; see
+// appendJsonUnescaped). Integer fields accept both 3 and "3".
+struct JsonFieldBinding {
+    std::string_view name;
+    std::string_view* text = nullptr;
+    int* number = nullptr;
+
+    JsonFieldBinding(std::string_view n, std::string_view* out) : name(n), text(out) {}
+    JsonFieldBinding(std::string_view n, int* out) : name(n), number(out) {}
+};
+
+class JsonScanner {
+private:
+    const char* p;
+    const char* end;
+
+    static unsigned lowestSetBit(unsigned mask) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (unsigned)index;
+#else
+        return (unsigned)__builtin_ctz(mask);
+#endif
+    }
+
+    // Advance p to the next '"' or '\\', or to end
+    void findStringDelimiter() {
+#if defined(__AVX2__)
+        const __m256i quote32 = _mm256_set1_epi8('"');
+        const __m256i backslash32 = _mm256_set1_epi8('\\');
+        while (end - p >= 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i*)p);
+            unsigned mask = (unsigned)_mm256_movemask_epi8(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32), _mm256_cmpeq_epi8(chunk, backslash32)));
+            if (mask) {
+                p += lowestSetBit(mask);
+                return;
+            }
+            p += 32;
+        }
+#endif
+#if defined(SQUID_JSON_SSE2)
+        const __m128i quote16 = _mm_set1_epi8('"');
+        const __m128i backslash16 = _mm_set1_epi8('\\');
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+            unsigned mask = (unsigned)_mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, quote16), _mm_cmpeq_epi8(chunk, backslash16)));
+            if (mask) {
+                p += lowestSetBit(mask);
+                return;
+            }
+            p += 16;
+        }
+#endif
+        while (p < end && *p != '"' && *p != '\\') p++;
+    }
+
+    void skipWhitespace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    }
+
+    // p is on the opening quote. Leaves p past the closing quote and returns
+    // the raw contents, or returns false if the string is unterminated.
+    bool scanString(std::string_view& out) {
+        const char* start = ++p;
+        while (true) {
+            findStringDelimiter();
+            if (p >= end) return false;
+            if (*p == '"') break;
+            p += 2; // backslash: skip the escaped character, including \"
+        }
+        out = std::string_view(start, (size_t)(p - start));
+        p++;
+        return true;
+    }
+
+    // Skip a nested object or array, minding strings that contain brackets
+    bool skipNested() {
+        int depth = 0;
+        while (p < end) {
+            char c = *p;
+            if (c == '"') {
+                std::string_view ignored;
+                if (!scanString(ignored)) return false;
+                continue;
+            }
+            if (c == '{' || c == '[') depth++;
+            else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    p++;
+                    return true;
+                }
+            }
+            p++;
+        }
+        return false;
+    }
+
+    static void storeNumber(std::string_view raw, int* out) {
+        const char* first = raw.data();
+        const char* last = first + raw.size();
+        while (first < last && *first == ' ') first++;
+        if (first < last && *first == '+') first++;
+        int value = 0;
+        // Stops at the first non-digit, so 3.7 reads as 3 like the old atoi path
+        if (std::from_chars(first, last, value).ec == std::errc()) *out = value;
+    }
+
+public:
+    JsonScanner(std::string_view json) : p(json.data()), end(json.data() + json.size()) {}
+
+    // See forEachJsonObject
+    template <typename F>
+    bool forEachObject(F&& fn) {
+        skipWhitespace();
+        if (p >= end || *p != '[') return false;
+        p++;
+        skipWhitespace();
+        if (p < end && *p == ']') return true;
+
+        while (p < end) {
+            if (*p != '{') return false;
+            const char* start = p;
+            if (!skipNested()) return false;
+            fn(std::string_view(start, (size_t)(p - start)));
+
+            skipWhitespace();
+            if (p >= end) return false;
+            if (*p == ']') return true;
+            if (*p != ',') return false;
+            p++;
+            skipWhitespace();
+        }
+        return false;
+    }
+
+    // One pass over a JSON object. Top-level members whose name matches a
+    // binding are stored; fields that are absent keep their prior value.
+    // Returns false if the body is not a well-formed object.
+    bool extract(std::initializer_list<JsonFieldBinding> fields) {
+        skipWhitespace();
+        if (p >= end || *p != '{') return false;
+        p++;
+        skipWhitespace();
+        if (p < end && *p == '}') return true;
+
+        while (p < end) {
+            std::string_view key;
+            if (*p != '"' || !scanString(key)) return false;
+            skipWhitespace();
+            if (p >= end || *p != ':') return false;
+            p++;
+            skipWhitespace();
+            if (p >= end) return false;
+
+            std::string_view value;
+            if (*p == '"') {
+                if (!scanString(value)) return false;
+            } else if (*p == '{' || *p == '[') {
+                if (!skipNested()) return false;
+            } else {
+                // Number, true, false or null
+                const char* start = p;
+                while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') p++;
+                value = std::string_view(start, (size_t)(p - start));
+            }
+
+            for (const JsonFieldBinding& field : fields) {
+                if (field.name != key) continue;
+                if (field.text) *field.text = value;
+                if (field.number) storeNumber(value, field.number);
+                break;
+            }
+
+            skipWhitespace();
+            if (p >= end) return false;
+            if (*p == '}') return true;
+            if (*p != ',') return false;
+            p++;
+            skipWhitespace();
+        }
+        return false;
+    }
+};
+
+inline bool extractJsonFields(std::string_view json, std::initializer_list<JsonFieldBinding> fields) {
+    return JsonScanner(json).extract(fields);
+}
+
+// Call fn(std::string_view) with the raw text of each element of an array of
+// objects, ready for extractJsonFields. Stops at the first element that is not
+// an object or is cut short and returns false; earlier elements have been
+// handed over by then.
+template <typename F>
+bool forEachJsonObject(std::string_view json, F&& fn) {
+    return JsonScanner(json).forEachObject(fn);
+}
+
+// Decode the escape sequences in a raw string value (as returned by
+// extractJsonFields). \uXXXX is emitted as UTF-8; surrogate pairs are joined.
+inline void appendJsonUnescaped(std::string& out, std::string_view raw) {
+    auto hexValue = [](std::string_view hex, unsigned& value) {
+        value = 0;
+        return hex.size() == 4 && std::from_chars(hex.data(), hex.data() + 4, value, 16).ptr == hex.data() + 4;
+    };
+    for (size_t i = 0; i < raw.size(); i++) {
+        char c = raw[i];
+        if (c != '\\' || i + 1 >= raw.size()) {
+            out += c;
+            continue;
+        }
+        char e = raw[++i];
+        switch (e) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                unsigned cp;
+                if (!hexValue(raw.substr(i + 1, 4), cp)) {
+                    out += e;
+                    break;
+                }
+                i += 4;
+                unsigned low;
+                if (cp >= 0xD800 && cp < 0xDC00 && raw.substr(i + 1, 2) == "\\u" && hexValue(raw.substr(i + 3, 4), low)
+                    && low >= 0xDC00 && low < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                if (cp < 0x80) {
+                    out += (char)cp;
+                } else if (cp < 0x800) {
+                    out += (char)(0xC0 | (cp >> 6));
+                    out += (char)(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    out += (char)(0xE0 | (cp >> 12));
+                    out += (char)(0x80 | ((cp >> 6) & 0x3F));
+                    out += (char)(0x80 | (cp & 0x3F));
+                } else {
+                    out += (char)(0xF0 | (cp >> 18));
+                    out += (char)(0x80 | ((cp >> 12) & 0x3F));
+                    out += (char)(0x80 | ((cp >> 6) & 0x3F));
+                    out += (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default: out += e; break; // \" \\ \/
+        }
+    }
+}
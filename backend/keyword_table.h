@@ -0,0 +1,124 @@
+// Compile-time perfect hashing for small fixed vocabularies
+//
+// Routes, methods and the action/choice/strategy words a request may carry
+// are known when the server is compiled. makeKeywordTable searches, at
+// compile time, for a seed under which every word lands in its own slot, so a
+// lookup mixes the length and three characters of the input with one
+// multiply, loads one slot and compares against the single word that can
+// live there, eight bytes at a time. Anything else maps to the table's
+// fallback value. A vocabulary with no collision-free seed fails to compile
+// (static_assert on perfect).
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+template <typename E>
+struct Keyword {
+    std::string_view text;
+    E value{};
+};
+
+template <typename E, size_t N>
+class KeywordTable {
+public:
+    static constexpr size_t slotCount() {
+        size_t slots = 4;
+        while (slots < N * 2) slots <<= 1;
+        return slots;
+    }
+    static constexpr size_t SLOTS = slotCount();
+
+    Keyword<E> words[N] = {};
+    uint64_t heads[N] = {}; // headOf/tailOf of each word
+    uint64_t tails[N] = {};
+    uint8_t slots[SLOTS] = {}; // index + 1 into words; 0 = empty
+    uint32_t seed = 0;
+    E fallback{};
+    bool perfect = false;
+
+    static constexpr int SHIFT = [] {
+        int bits = 0;
+        while (((size_t)1 << bits) < SLOTS) bits++;
+        return 32 - bits;
+    }();
+
+    // Length and first, middle and last characters, spread by one multiply;
+    // the top bits pick the slot
+    static constexpr size_t slotOf(std::string_view s, uint32_t seed) {
+        if (s.empty()) return 0;
+        uint32_t key = (uint32_t)s.size() | (uint32_t)(unsigned char)s[0] << 8 |
+                       (uint32_t)(unsigned char)s[s.size() / 2] << 16 | (uint32_t)(unsigned char)s[s.size() - 1] << 24;
+        return (size_t)((key * (0x9E3779B1u + 2 * seed)) >> SHIFT);
+    }
+
+    // First and last 8 bytes (4 for shorter words, the whole word below 4),
+    // read little-endian. Together they cover any word of up to 16 bytes, so
+    // a comparison is two loads and two compares.
+    static constexpr uint64_t pack(const char* p, size_t n) {
+        uint64_t v = 0;
+        for (size_t i = 0; i < n; i++) v |= (uint64_t)(unsigned char)p[i] << (8 * i);
+        return v;
+    }
+    static constexpr uint64_t headOf(std::string_view s) { return pack(s.data(), s.size() >= 8 ? 8 : s.size() >= 4 ? 4 : s.size()); }
+    static constexpr uint64_t tailOf(std::string_view s) {
+        return s.size() >= 8 ? pack(s.data() + s.size() - 8, 8) : s.size() >= 4 ? pack(s.data() + s.size() - 4, 4) : 0;
+    }
+
+    // headOf/tailOf for the request side, as plain loads
+    template <typename T>
+    static uint64_t loadLE(const char* p) {
+        T v;
+        std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        return sizeof(T) == 8 ? __builtin_bswap64(v) : __builtin_bswap32((uint32_t)v);
+#else
+        return v;
+#endif
+    }
+    static bool sameEnds(std::string_view s, uint64_t head, uint64_t tail) {
+        const char* p = s.data();
+        size_t n = s.size();
+        if (n >= 8) return loadLE<uint64_t>(p) == head && loadLE<uint64_t>(p + n - 8) == tail;
+        if (n >= 4) return loadLE<uint32_t>(p) == head && loadLE<uint32_t>(p + n - 4) == tail;
+        return pack(p, n) == head;
+    }
+
+    E lookup(std::string_view s) const {
+        uint8_t slot = slots[slotOf(s, seed)];
+        if (!slot || words[slot - 1].text.size() != s.size()) return fallback;
+        const Keyword<E>& word = words[slot - 1];
+        if (s.size() > 16) return word.text == s ? word.value : fallback;
+        return sameEnds(s, heads[slot - 1], tails[slot - 1]) ? word.value : fallback;
+    }
+};
+
+template <typename E, size_t N>
+constexpr KeywordTable<E, N> makeKeywordTable(const Keyword<E> (&words)[N], E fallback) {
+    static_assert(N < 255, "slots hold a one-byte index");
+    using Table = KeywordTable<E, N>;
+    Table table;
+    table.fallback = fallback;
+    for (size_t i = 0; i < N; i++) {
+        table.words[i] = words[i];
+        table.heads[i] = Table::headOf(words[i].text);
+        table.tails[i] = Table::tailOf(words[i].text);
+    }
+    for (uint32_t seed = 0; seed < 4096; seed++) {
+        for (size_t s = 0; s < Table::SLOTS; s++) table.slots[s] = 0;
+        bool collided = false;
+        for (size_t i = 0; i < N && !collided; i++) {
+            size_t slot = Table::slotOf(words[i].text, seed);
+            if (table.slots[slot]) collided = true;
+            else table.slots[slot] = (uint8_t)(i + 1);
+        }
+        if (!collided) {
+            table.seed = seed;
+            table.perfect = true;
+            break;
+        }
+    }
+    return table;
+}
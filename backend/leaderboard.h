@@ -0,0 +1,227 @@
+// Leaderboard over the results log
+//
+// Request threads hand finished runs to ResultsStore through per-thread
+// single-producer rings, like the logger: no lock, no allocation, no disk
+// I/O on the request path, and a result that finds its ring full is dropped
+// and counted. A background committer drains every ring, appends the batch to
+// the log and syncs it once (group commit: one msync covers every result
+// that arrived during the previous one). Only then are the results added to
+// the in-memory index, so the leaderboard never shows a result a crash could
+// take back.
+//
+// The index keeps each player's best result per game in a score-ordered tree,
+// capped at MAX_ENTRIES per game, and is rebuilt from the log at startup.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "logger.h"
+#include "results_log.h"
+#include "rng.h"
+
+class Leaderboard {
+public:
+    static const size_t MAX_ENTRIES = 10000; // per game
+
+private:
+    // Higher score first, then the earlier result, then any stable order
+    struct Rank {
+        uint32_t score;
+        uint64_t timeMs;
+        uint64_t player;
+        bool operator<(const Rank& o) const {
+            if (score != o.score) return score > o.score;
+            if (timeMs != o.timeMs) return timeMs < o.timeMs;
+            return player < o.player;
+        }
+    };
+
+    struct Board {
+        std::map<Rank, ResultRecord> ranking;
+        std::unordered_map<uint64_t, Rank> best; // player -> their entry in ranking
+    };
+
+    Board boards[(int)ResultGame::Count];
+
+    static uint64_t playerKey(std::string_view name) {
+        uint64_t h = 0xCBF29CE484222325ull; // FNV-1a
+        for (char c : name) {
+            h ^= (unsigned char)c;
+            h *= 0x100000001B3ull;
+        }
+        return splitMix64(h);
+    }
+
+public:
+    // Keep r if it is the player's best result in its game
+    void add(const ResultRecord& r) {
+        if (r.game >= (uint8_t)ResultGame::Count) return;
+        Board& board = boards[r.game];
+        Rank rank{r.score, r.timeMs, playerKey(r.playerName())};
+        auto known = board.best.find(rank.player);
+        if (known != board.best.end()) {
+            if (!(rank < known->second)) return;
+            board.ranking.erase(known->second);
+            known->second = rank;
+        } else {
+            if (board.ranking.size() >= MAX_ENTRIES && !(rank < board.ranking.rbegin()->first)) return;
+            board.best.emplace(rank.player, rank);
+        }
+        board.ranking.emplace(rank, r);
+        if (board.ranking.size() > MAX_ENTRIES) {
+            auto last = std::prev(board.ranking.end());
+            board.best.erase(last->first.player);
+            board.ranking.erase(last);
+        }
+    }
+
+    // fn(const ResultRecord&) for the best `limit` players, best first
+    template <typename F>
+    void top(ResultGame game, size_t limit, F&& fn) const {
+        if (game >= ResultGame::Count) return;
+        for (const auto& entry : boards[(int)game].ranking) {
+            if (limit-- == 0) break;
+            fn(entry.second);
+        }
+    }
+};
+
+class ResultsStore {
+private:
+    static const size_t RING_SIZE = 4096; // results per thread, power of two
+
+    // Single producer (the owning thread), single consumer (the committer)
+    struct Ring {
+        ResultRecord records[RING_SIZE];
+        alignas(64) std::atomic<size_t> head{0};
+        alignas(64) std::atomic<size_t> tail{0};
+        std::atomic<bool> retired{false};
+    };
+
+    struct ThreadHandle {
+        std::shared_ptr<Ring> ring;
+        ~ThreadHandle() {
+            if (ring) ring->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    ResultsLog log;                // committer-owned once open() returns
+    Leaderboard board;
+    mutable std::mutex boardLock;  // committer writes, /leaderboard reads
+    std::mutex registryLock;       // taken once per thread, never per result
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::thread committer;
+    std::atomic<bool> running{false};
+
+    Ring& threadRing() {
+        thread_local ThreadHandle handle;
+        if (!handle.ring) {
+            handle.ring = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> guard(registryLock);
+            rings.push_back(handle.ring);
+        }
+        return *handle.ring;
+    }
+
+    // Move every queued result into the log, sync, then index; returns the count
+    size_t commitOnce(std::vector<ResultRecord>& batch) {
+        std::vector<std::shared_ptr<Ring>> snapshot;
+        {
+            std::lock_guard<std::mutex> guard(registryLock);
+            snapshot = rings;
+        }
+        for (auto& ring : snapshot) {
+            bool retired = ring->retired.load(std::memory_order_acquire);
+            size_t tail = ring->tail.load(std::memory_order_relaxed);
+            size_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++) batch.push_back(ring->records[tail & (RING_SIZE - 1)]);
+            ring->tail.store(tail, std::memory_order_release);
+            if (retired) {
+                std::lock_guard<std::mutex> guard(registryLock);
+                for (size_t i = 0; i < rings.size(); i++) {
+                    if (rings[i] == ring) {
+                        rings.erase(rings.begin() + i);
+                        break;
+                    }
+                }
+            }
+        }
+        if (batch.empty()) return 0;
+
+        size_t committed = batch.size();
+        std::string error;
+        if (!log.append(batch.data(), batch.size(), error) || !log.sync()) {
+            SQUID_LOG(LogLevel::Error, "results log write failed");
+            committed = 0;
+        } else {
+            std::lock_guard<std::mutex> guard(boardLock);
+            for (const ResultRecord& r : batch) board.add(r);
+        }
+        batch.clear();
+        return committed;
+    }
+
+public:
+    static ResultsStore& instance() {
+        static ResultsStore store;
+        return store;
+    }
+
+    ~ResultsStore() { stop(); }
+
+    // Open the log, rebuild the index from it and start committing
+    bool open(const std::string& path, std::string& error) {
+        if (running.load()) return true;
+        if (!log.open(path, error)) return false;
+        {
+            std::lock_guard<std::mutex> guard(boardLock);
+            for (size_t i = 0; i < log.size(); i++) board.add(log[i]);
+        }
+        running.store(true);
+        committer = std::thread([this]() {
+            std::vector<ResultRecord> batch;
+            while (running.load(std::memory_order_relaxed)) {
+                if (commitOnce(batch) == 0) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            commitOnce(batch);
+        });
+        return true;
+    }
+
+    void stop() {
+        if (!running.exchange(false)) return;
+        if (committer.joinable()) committer.join();
+        log.close();
+    }
+
+    bool enabled() const { return running.load(std::memory_order_relaxed); }
+
+    // Queue a result for the log; false if the store is closed or this
+    // thread's ring is full
+    bool record(const ResultRecord& r) {
+        if (!enabled()) return false;
+        Ring& ring = threadRing();
+        size_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) >= RING_SIZE) return false;
+        ring.records[head & (RING_SIZE - 1)] = r;
+        ring.head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // fn(const ResultRecord&) for the best `limit` players of a game
+    template <typename F>
+    void top(ResultGame game, size_t limit, F&& fn) const {
+        std::lock_guard<std::mutex> guard(boardLock);
+        board.top(game, limit, fn);
+    }
+};
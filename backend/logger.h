@@ -0,0 +1,242 @@
+// Asynchronous request logging
+//
+// Worker threads never write to stdout themselves. Each thread appends
+// fixed-size records to its own single-producer ring buffer (no locks, no
+// allocation); a background thread drains all rings every few milliseconds
+// and writes each batch with one fwrite. If a ring is full the record is
+// dropped and counted rather than stalling the request, and the drop count
+// is reported in the log itself.
+//
+// SQUID_LOG compiles away entirely for levels below SQUID_LOG_MIN_LEVEL and
+// otherwise costs one relaxed load when the runtime level filters it out.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+enum class LogLevel : uint8_t { Debug = 0, Info = 1, Warn = 2, Error = 3, Off = 4 };
+
+#ifndef SQUID_LOG_MIN_LEVEL
+    #define SQUID_LOG_MIN_LEVEL 0 // build with -DSQUID_LOG_MIN_LEVEL=4 to compile all logging out
+#endif
+
+// One log line: a static event name plus the structured request fields
+struct LogRecord {
+    int64_t wallTimeNs;
+    const char* event; // string literal
+    uint32_t latencyUs;
+    uint16_t status;
+    LogLevel level;
+    uint8_t endpointLen;
+    char endpoint[40]; // truncated copy; the request buffer is reused
+};
+
+class Logger {
+private:
+    static const size_t RING_SIZE = 4096; // records per thread, power of two
+
+    // Single producer (the owning thread), single consumer (the drainer)
+    struct Ring {
+        LogRecord records[RING_SIZE];
+        alignas(64) std::atomic<size_t> head{0}; // next write, producer-owned
+        alignas(64) std::atomic<size_t> tail{0}; // next read, consumer-owned
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> retired{false};        // owning thread has exited
+    };
+
+    // Keeps the thread's ring alive until the drainer has emptied it
+    struct ThreadHandle {
+        std::shared_ptr<Ring> ring;
+        ~ThreadHandle() {
+            if (ring) ring->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    std::atomic<LogLevel> minLevel{LogLevel::Info};
+    std::mutex registryLock; // taken once per thread, never per record
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::thread drainer;
+    std::atomic<bool> running{false};
+    FILE* out = stdout;
+    uint64_t droppedReported = 0; // drainer-owned
+    uint64_t droppedRetired = 0;  // drops from rings of exited threads
+
+    Ring& threadRing() {
+        thread_local ThreadHandle handle;
+        if (!handle.ring) {
+            handle.ring = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> guard(registryLock);
+            rings.push_back(handle.ring);
+        }
+        return *handle.ring;
+    }
+
+    static const char* levelName(LogLevel level) {
+        switch (level) {
+            case LogLevel::Debug: return "DEBUG";
+            case LogLevel::Info: return "INFO";
+            case LogLevel::Warn: return "WARN";
+            case LogLevel::Error: return "ERROR";
+            default: return "";
+        }
+    }
+
+    static void format(std::string& batch, const LogRecord& r) {
+        char line[192];
+        time_t seconds = (time_t)(r.wallTimeNs / 1000000000);
+        int millis = (int)((r.wallTimeNs / 1000000) % 1000);
+        struct tm utc;
+#ifdef _WIN32
+        gmtime_s(&utc, &seconds);
+#else
+        gmtime_r(&seconds, &utc);
+#endif
+        int n = snprintf(line, sizeof(line), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ %s %s", utc.tm_year + 1900,
+                         utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, millis,
+                         levelName(r.level), r.event);
+        batch.append(line, (size_t)n);
+        if (r.endpointLen) {
+            batch.append(" endpoint=");
+            batch.append(r.endpoint, r.endpointLen);
+        }
+        if (r.status) {
+            n = snprintf(line, sizeof(line), " status=%u latency_us=%u", (unsigned)r.status, (unsigned)r.latencyUs);
+            batch.append(line, (size_t)n);
+        }
+        batch += '\n';
+    }
+
+    // Move everything currently buffered to the output; returns records written
+    size_t drainOnce(std::string& batch) {
+        std::vector<std::shared_ptr<Ring>> snapshot;
+        {
+            std::lock_guard<std::mutex> guard(registryLock);
+            snapshot = rings;
+        }
+
+        size_t drained = 0;
+        uint64_t droppedTotal = droppedRetired;
+        for (auto& ring : snapshot) {
+            bool retired = ring->retired.load(std::memory_order_acquire);
+            size_t tail = ring->tail.load(std::memory_order_relaxed);
+            size_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++, drained++) {
+                format(batch, ring->records[tail & (RING_SIZE - 1)]);
+            }
+            ring->tail.store(tail, std::memory_order_release);
+
+            uint64_t dropped = ring->dropped.load(std::memory_order_relaxed);
+            droppedTotal += dropped;
+            if (retired) {
+                // The owning thread is gone and its ring is empty; forget it
+                droppedRetired += dropped;
+                std::lock_guard<std::mutex> guard(registryLock);
+                for (size_t i = 0; i < rings.size(); i++) {
+                    if (rings[i] == ring) {
+                        rings.erase(rings.begin() + i);
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (droppedTotal > droppedReported) {
+            char line[96];
+            int n = snprintf(line, sizeof(line), "WARN logger dropped=%llu (log rings full)\n",
+                             (unsigned long long)(droppedTotal - droppedReported));
+            batch.append(line, (size_t)n);
+            droppedReported = droppedTotal;
+        }
+
+        if (!batch.empty()) {
+            fwrite(batch.data(), 1, batch.size(), out);
+            fflush(out);
+            batch.clear();
+        }
+        return drained;
+    }
+
+public:
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    ~Logger() { stop(); }
+
+    void setLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+
+    bool enabled(LogLevel level) const { return level >= minLevel.load(std::memory_order_relaxed); }
+
+    // Start the background writer; records logged before this are buffered
+    void start(FILE* output = stdout) {
+        if (running.exchange(true)) return;
+        out = output;
+        drainer = std::thread([this]() {
+            std::string batch;
+            while (running.load(std::memory_order_relaxed)) {
+                if (drainOnce(batch) == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            drainOnce(batch);
+        });
+    }
+
+    void stop() {
+        if (!running.exchange(false)) return;
+        if (drainer.joinable()) drainer.join();
+    }
+
+    void log(LogLevel level, const char* event, std::string_view endpoint = {}, int status = 0, uint32_t latencyUs = 0) {
+        Ring& ring = threadRing();
+        size_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) >= RING_SIZE) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        LogRecord& r = ring.records[head & (RING_SIZE - 1)];
+        r.wallTimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch()).count();
+        r.event = event;
+        r.latencyUs = latencyUs;
+        r.status = (uint16_t)status;
+        r.level = level;
+        r.endpointLen = (uint8_t)(endpoint.size() < sizeof(r.endpoint) ? endpoint.size() : sizeof(r.endpoint));
+        memcpy(r.endpoint, endpoint.data(), r.endpointLen);
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    static bool parseLevel(std::string_view name, LogLevel& level) {
+        if (name == "debug") level = LogLevel::Debug;
+        else if (name == "info") level = LogLevel::Info;
+        else if (name == "warn") level = LogLevel::Warn;
+        else if (name == "error") level = LogLevel::Error;
+        else if (name == "off") level = LogLevel::Off;
+        else return false;
+        return true;
+    }
+};
+
+// Whether a level survives SQUID_LOG_MIN_LEVEL. At the default of 0 every
+// level does, and there is no comparison to warn about (-Wtype-limits).
+#if SQUID_LOG_MIN_LEVEL > 0
+    #define SQUID_LOG_COMPILED_IN(level) ((int)(level) >= SQUID_LOG_MIN_LEVEL)
+#else
+    #define SQUID_LOG_COMPILED_IN(level) true
+#endif
+
+#define SQUID_LOG(level, ...)                                                       \
+    do {                                                                            \
+        if (SQUID_LOG_COMPILED_IN(level) && Logger::instance().enabled(level))      \
+            Logger::instance().log(level, __VA_ARGS__);                             \
+    } while (0)
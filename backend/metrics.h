@@ -0,0 +1,273 @@
+// Server metrics
+//
+// Every thread updates its own ThreadMetrics block, so recording a request is
+// a handful of uncontended relaxed stores with no lock-prefixed instructions
+// and no cache-line sharing between workers. A /metrics scrape sums the blocks
+// of all threads and renders Prometheus text.
+//
+// Latencies go into log-linear (HDR-style) histograms: 8 sub-buckets per
+// power of two of nanoseconds, so any recorded value is known to within 12.5%
+// from 1 ns up to about a minute, in about 2 KB per route per thread.
+#pragma once
+
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+enum MetricsRoute { ROUTE_REDLIGHT, ROUTE_GLASSBRIDGE, ROUTE_TUGOFWAR, ROUTE_BATCH, ROUTE_LEADERBOARD, ROUTE_STATIC, ROUTE_UNKNOWN, ROUTE_COUNT };
+
+inline const char* metricsRouteName(int route) {
+    static const char* const names[ROUTE_COUNT] = {"redlight", "glassbridge", "tugofwar", "batch", "leaderboard", "static", "unknown"};
+    return names[route];
+}
+
+// Single-writer counter: only the owning thread increments, so a relaxed
+// load + store is enough and readers on other threads see a coherent value
+class LocalCounter {
+private:
+    std::atomic<uint64_t> value{0};
+
+public:
+    void add(uint64_t n = 1) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int MAX_EXPONENT = 36; // 2^36 ns, about 69 s; larger values land in the last bucket
+    static const int BUCKETS = (MAX_EXPONENT - SUB_BITS + 2) * SUB_BUCKETS;
+
+    static int highestSetBit(uint64_t v) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, v);
+        return (int)index;
+#else
+        return 63 - __builtin_clzll(v);
+#endif
+    }
+
+    static int bucketFor(uint64_t ns) {
+        if (ns < (uint64_t)SUB_BUCKETS) return (int)ns;
+        int exponent = highestSetBit(ns);
+        if (exponent > MAX_EXPONENT) return BUCKETS - 1;
+        int sub = (int)((ns >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+        return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+    }
+
+    // Largest value that maps to bucket
+    static uint64_t bucketUpperBound(int bucket) {
+        if (bucket < SUB_BUCKETS) return (uint64_t)bucket;
+        int exponent = bucket / SUB_BUCKETS + SUB_BITS - 1;
+        uint64_t sub = (uint64_t)(bucket % SUB_BUCKETS);
+        return ((SUB_BUCKETS + sub + 1) << (exponent - SUB_BITS)) - 1;
+    }
+
+    void record(uint64_t ns) {
+        counts[bucketFor(ns)].add();
+        sumNs.add(ns);
+    }
+
+    LocalCounter counts[BUCKETS];
+    LocalCounter sumNs;
+};
+
+struct alignas(64) ThreadMetrics {
+    LatencyHistogram latency[ROUTE_COUNT];
+    LocalCounter bytesIn;
+    LocalCounter bytesOut;
+    LocalCounter connectionsOpened;
+    LocalCounter connectionsClosed;
+    LocalCounter acceptErrors;
+    LocalCounter parseFailures;
+    LocalCounter streamsOpened;
+    LocalCounter streamsClosed;
+    LocalCounter eventsPublished;
+    LocalCounter eventDeliveries;
+    LocalCounter batchActions;
+    LocalCounter resultsRecorded;
+    LocalCounter resultsDropped;
+    LocalCounter staticNotModified;
+    LocalCounter staticFileBytes;
+    LocalCounter connectionsRejected;
+    LocalCounter rateLimited;
+    LocalCounter requestsShed;
+};
+
+class Metrics {
+private:
+    std::mutex registryLock; // taken once per thread, never per update
+    std::vector<std::unique_ptr<ThreadMetrics>> threads;
+
+    static void appendNumber(std::string& out, uint64_t value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, (size_t)(result.ptr - digits));
+    }
+
+    static void appendSeconds(std::string& out, uint64_t ns) {
+        char text[32];
+        int n = snprintf(text, sizeof(text), "%.9g", (double)ns / 1e9);
+        out.append(text, (size_t)n);
+    }
+
+    static void appendCounter(std::string& out, const char* name, const char* help, const char* type, uint64_t value) {
+        out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+        out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+        out.append(name).append(" ");
+        appendNumber(out, value);
+        out += '\n';
+    }
+
+    // Value at quantile q of a merged histogram (upper bound of its bucket)
+    static uint64_t quantile(const uint64_t* counts, uint64_t total, double q) {
+        uint64_t rank = (uint64_t)(q * (double)total);
+        if (rank >= total) rank = total - 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+            seen += counts[b];
+            if (seen > rank) return LatencyHistogram::bucketUpperBound(b);
+        }
+        return LatencyHistogram::bucketUpperBound(LatencyHistogram::BUCKETS - 1);
+    }
+
+public:
+    static Metrics& instance() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    // The calling thread's block, registered on first use
+    static ThreadMetrics& local() {
+        thread_local ThreadMetrics* mine = nullptr;
+        if (!mine) {
+            Metrics& all = instance();
+            std::lock_guard<std::mutex> guard(all.registryLock);
+            all.threads.emplace_back(new ThreadMetrics());
+            mine = all.threads.back().get();
+        }
+        return *mine;
+    }
+
+    // Prometheus text exposition format 0.0.4
+    void writePrometheus(std::string& out) {
+        std::lock_guard<std::mutex> guard(registryLock);
+
+        uint64_t bytesIn = 0, bytesOut = 0, opened = 0, closed = 0, acceptErrors = 0, parseFailures = 0;
+        uint64_t streamsOpened = 0, streamsClosed = 0, eventsPublished = 0, eventDeliveries = 0, batchActions = 0;
+        uint64_t resultsRecorded = 0, resultsDropped = 0, staticNotModified = 0, staticFileBytes = 0;
+        uint64_t connectionsRejected = 0, rateLimited = 0, requestsShed = 0;
+        for (auto& t : threads) {
+            bytesIn += t->bytesIn.get();
+            bytesOut += t->bytesOut.get();
+            opened += t->connectionsOpened.get();
+            closed += t->connectionsClosed.get();
+            acceptErrors += t->acceptErrors.get();
+            parseFailures += t->parseFailures.get();
+            streamsOpened += t->streamsOpened.get();
+            streamsClosed += t->streamsClosed.get();
+            eventsPublished += t->eventsPublished.get();
+            eventDeliveries += t->eventDeliveries.get();
+            batchActions += t->batchActions.get();
+            resultsRecorded += t->resultsRecorded.get();
+            resultsDropped += t->resultsDropped.get();
+            staticNotModified += t->staticNotModified.get();
+            staticFileBytes += t->staticFileBytes.get();
+            connectionsRejected += t->connectionsRejected.get();
+            rateLimited += t->rateLimited.get();
+            requestsShed += t->requestsShed.get();
+        }
+
+        appendCounter(out, "squid_bytes_received_total", "Bytes read from client sockets.", "counter", bytesIn);
+        appendCounter(out, "squid_bytes_sent_total", "Bytes written to client sockets.", "counter", bytesOut);
+        appendCounter(out, "squid_connections_accepted_total", "Client connections accepted.", "counter", opened);
+        appendCounter(out, "squid_active_connections", "Client connections currently open.", "gauge",
+                      opened >= closed ? opened - closed : 0);
+        appendCounter(out, "squid_accept_errors_total", "Failed accept() calls.", "counter", acceptErrors);
+        appendCounter(out, "squid_parse_failures_total", "Requests rejected as malformed or too large.", "counter",
+                      parseFailures);
+        appendCounter(out, "squid_event_streams", "Open /events subscriptions.", "gauge",
+                      streamsOpened >= streamsClosed ? streamsOpened - streamsClosed : 0);
+        appendCounter(out, "squid_events_published_total", "Room events serialized for subscribers.", "counter",
+                      eventsPublished);
+        appendCounter(out, "squid_event_deliveries_total", "Event frames queued on subscriber connections.", "counter",
+                      eventDeliveries);
+        appendCounter(out, "squid_batch_actions_total", "Game actions run through /batch.", "counter", batchActions);
+        appendCounter(out, "squid_results_recorded_total", "Finished runs queued for the results log.", "counter",
+                      resultsRecorded);
+        appendCounter(out, "squid_results_dropped_total", "Finished runs not logged because the queue was full.",
+                      "counter", resultsDropped);
+        appendCounter(out, "squid_static_not_modified_total", "Frontend file requests answered 304 from the ETag.",
+                      "counter", staticNotModified);
+        appendCounter(out, "squid_static_sendfile_bytes_total", "Frontend file bytes sent with sendfile.", "counter",
+                      staticFileBytes);
+        appendCounter(out, "squid_connections_rejected_total", "Connections turned away at the connection limit.",
+                      "counter", connectionsRejected);
+        appendCounter(out, "squid_rate_limited_total", "Requests answered 429 because the client was over its rate.",
+                      "counter", rateLimited);
+        appendCounter(out, "squid_requests_shed_total", "Requests answered 503 because they queued too long.", "counter",
+                      requestsShed);
+
+        // Merge each route's histogram across threads once, then render
+        std::vector<uint64_t> merged(LatencyHistogram::BUCKETS);
+        std::string quantiles;
+        out.append("# HELP squid_request_duration_seconds Time from parsed request to serialized response.\n"
+                   "# TYPE squid_request_duration_seconds histogram\n");
+        quantiles.append("# HELP squid_request_duration_quantile_seconds Latency quantiles from the full-resolution histogram.\n"
+                         "# TYPE squid_request_duration_quantile_seconds gauge\n");
+        for (int route = 0; route < ROUTE_COUNT; route++) {
+            uint64_t total = 0, sumNs = 0;
+            for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+                uint64_t count = 0;
+                for (auto& t : threads) count += t->latency[route].counts[b].get();
+                merged[b] = count;
+                total += count;
+            }
+            for (auto& t : threads) sumNs += t->latency[route].sumNs.get();
+
+            // Exported buckets end on powers of two, which are also bucket edges
+            // of the internal histogram, so the cumulative counts are exact
+            uint64_t cumulative = 0;
+            for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+                cumulative += merged[b];
+                bool powerOfTwoEdge = b >= LatencyHistogram::SUB_BUCKETS && b % LatencyHistogram::SUB_BUCKETS == LatencyHistogram::SUB_BUCKETS - 1;
+                if (!powerOfTwoEdge || b == LatencyHistogram::BUCKETS - 1) continue;
+                out.append("squid_request_duration_seconds_bucket{route=\"").append(metricsRouteName(route)).append("\",le=\"");
+                appendSeconds(out, LatencyHistogram::bucketUpperBound(b));
+                out.append("\"} ");
+                appendNumber(out, cumulative);
+                out += '\n';
+            }
+            out.append("squid_request_duration_seconds_bucket{route=\"").append(metricsRouteName(route)).append("\",le=\"+Inf\"} ");
+            appendNumber(out, total);
+            out.append("\nsquid_request_duration_seconds_sum{route=\"").append(metricsRouteName(route)).append("\"} ");
+            appendSeconds(out, sumNs);
+            out.append("\nsquid_request_duration_seconds_count{route=\"").append(metricsRouteName(route)).append("\"} ");
+            appendNumber(out, total);
+            out += '\n';
+
+            if (total == 0) continue;
+            static const char* const labels[] = {"0.5", "0.9", "0.99", "0.999"};
+            static const double qs[] = {0.5, 0.9, 0.99, 0.999};
+            for (int i = 0; i < 4; i++) {
+                quantiles.append("squid_request_duration_quantile_seconds{route=\"").append(metricsRouteName(route));
+                quantiles.append("\",quantile=\"").append(labels[i]).append("\"} ");
+                appendSeconds(quantiles, quantile(merged.data(), total, qs[i]));
+                quantiles += '\n';
+            }
+        }
+        out += quantiles;
+    }
+};
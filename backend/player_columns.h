@@ -0,0 +1,230 @@
+// Column storage for large player tables
+//
+// The game controller keeps players as a structure of arrays: one contiguous
+// column per field, alive flags packed 64 to a word, and names interned into
+// a single character pool. Elimination passes then read only the columns they
+// need; the scans below compare 4 (AVX2) or 2 (SSE2) strengths per
+// instruction and skip fully eliminated blocks of 64 players by word.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SQUID_COLUMNS_SSE2 1
+#endif
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+inline int countBits(uint64_t word) {
+#if defined(_MSC_VER)
+    return (int)__popcnt64(word);
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+inline int lowestBit(uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Interned strings addressed by a dense 32-bit id. Interning the same text
+// twice returns the same id; lookups hash the text and never allocate.
+class NamePool {
+private:
+    std::string chars;
+    std::vector<uint32_t> offsets{0}; // name id -> [offsets[id], offsets[id + 1])
+    std::vector<uint32_t> slots;      // open addressing, id + 1 (0 = empty)
+
+    static uint64_t hash(std::string_view text) {
+        uint64_t h = 0xCBF29CE484222325ull; // FNV-1a
+        for (char c : text) {
+            h ^= (unsigned char)c;
+            h *= 0x100000001B3ull;
+        }
+        return h ^ (h >> 29);
+    }
+
+    void rehash(size_t capacity) {
+        slots.assign(capacity, 0);
+        for (uint32_t id = 0; id < size(); id++) {
+            size_t i = hash(view(id)) & (capacity - 1);
+            while (slots[i]) i = (i + 1) & (capacity - 1);
+            slots[i] = id + 1;
+        }
+    }
+
+public:
+    size_t size() const { return offsets.size() - 1; }
+
+    std::string_view view(uint32_t id) const {
+        return std::string_view(chars.data() + offsets[id], offsets[id + 1] - offsets[id]);
+    }
+
+    uint32_t intern(std::string_view text) {
+        if ((size() + 1) * 2 > slots.size()) rehash(slots.empty() ? 64 : slots.size() * 2);
+        size_t mask = slots.size() - 1;
+        size_t i = hash(text) & mask;
+        while (slots[i]) {
+            if (view(slots[i] - 1) == text) return slots[i] - 1;
+            i = (i + 1) & mask;
+        }
+        uint32_t id = (uint32_t)size();
+        chars.append(text.data(), text.size());
+        offsets.push_back((uint32_t)chars.size());
+        slots[i] = id + 1;
+        return id;
+    }
+};
+
+// One flag per row, packed 64 to a word; bits past size() are always 0
+class BitColumn {
+private:
+    std::vector<uint64_t> words;
+    size_t rows = 0;
+
+public:
+    size_t size() const { return rows; }
+    size_t wordCount() const { return words.size(); }
+    uint64_t word(size_t w) const { return words[w]; }
+    uint64_t& word(size_t w) { return words[w]; }
+
+    void clear() {
+        words.clear();
+        rows = 0;
+    }
+    void push(bool value) {
+        if (rows % 64 == 0) words.push_back(0);
+        if (value) words[rows / 64] |= 1ull << (rows % 64);
+        rows++;
+    }
+    bool test(size_t i) const { return (words[i / 64] >> (i % 64)) & 1; }
+    void set(size_t i) { words[i / 64] |= 1ull << (i % 64); }
+    void reset(size_t i) { words[i / 64] &= ~(1ull << (i % 64)); }
+
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t w : words) total += (size_t)countBits(w);
+        return total;
+    }
+
+    // Row of the k-th set bit (0-based); size() if there are not that many
+    size_t nth(size_t k) const {
+        for (size_t w = 0; w < words.size(); w++) {
+            size_t here = (size_t)countBits(words[w]);
+            if (k < here) {
+                uint64_t bits = words[w];
+                for (; k > 0; k--) bits &= bits - 1;
+                return w * 64 + (size_t)lowestBit(bits);
+            }
+            k -= here;
+        }
+        return rows;
+    }
+
+    // fn(row) for each set bit in row order. Each word is read before its
+    // rows are visited, so fn may clear the bit of the row it is given.
+    template <typename F>
+    void forEachSet(F&& fn) const {
+        for (size_t w = 0; w < words.size(); w++) {
+            for (uint64_t bits = words[w]; bits; bits &= bits - 1) fn(w * 64 + (size_t)lowestBit(bits));
+        }
+    }
+};
+
+// Bit j set where values[j] < threshold, for 64 consecutive values
+inline uint64_t lessMask64(const double* values, double threshold) {
+    uint64_t mask = 0;
+#if defined(__AVX2__)
+    const __m256d limit = _mm256_set1_pd(threshold);
+    for (int j = 0; j < 64; j += 4) {
+        __m256d v = _mm256_loadu_pd(values + j);
+        mask |= (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(v, limit, _CMP_LT_OQ)) << j;
+    }
+#elif defined(SQUID_COLUMNS_SSE2)
+    const __m128d limit = _mm_set1_pd(threshold);
+    for (int j = 0; j < 64; j += 2) {
+        __m128d v = _mm_loadu_pd(values + j);
+        mask |= (uint64_t)_mm_movemask_pd(_mm_cmplt_pd(v, limit)) << j;
+    }
+#else
+    for (int j = 0; j < 64; j++) mask |= (uint64_t)(values[j] < threshold) << j;
+#endif
+    return mask;
+}
+
+// Largest of 64 consecutive values
+inline double max64(const double* values) {
+#if defined(__AVX2__)
+    __m256d best = _mm256_loadu_pd(values);
+    for (int j = 4; j < 64; j += 4) best = _mm256_max_pd(best, _mm256_loadu_pd(values + j));
+    __m128d pair = _mm_max_pd(_mm256_castpd256_pd128(best), _mm256_extractf128_pd(best, 1));
+    return _mm_cvtsd_f64(_mm_max_sd(pair, _mm_unpackhi_pd(pair, pair)));
+#elif defined(SQUID_COLUMNS_SSE2)
+    __m128d best = _mm_loadu_pd(values);
+    for (int j = 2; j < 64; j += 2) best = _mm_max_pd(best, _mm_loadu_pd(values + j));
+    return _mm_cvtsd_f64(_mm_max_sd(best, _mm_unpackhi_pd(best, best)));
+#else
+    double best = values[0];
+    for (int j = 1; j < 64; j++) best = values[j] > best ? values[j] : best;
+    return best;
+#endif
+}
+
+// Largest column value over rows whose bit is set; -infinity if none are
+inline double maxWhereSet(const BitColumn& rows, const double* column) {
+    double best = -std::numeric_limits<double>::infinity();
+    size_t fullWords = rows.size() / 64;
+    for (size_t w = 0; w < rows.wordCount(); w++) {
+        uint64_t bits = rows.word(w);
+        if (bits == 0) continue;
+        double candidate;
+        if (bits == ~0ull && w < fullWords) {
+            candidate = max64(column + w * 64);
+        } else {
+            candidate = -std::numeric_limits<double>::infinity();
+            for (; bits; bits &= bits - 1) {
+                double v = column[w * 64 + (size_t)lowestBit(bits)];
+                if (v > candidate) candidate = v;
+            }
+        }
+        if (candidate > best) best = candidate;
+    }
+    return best;
+}
+
+// Clear the bit of every set row whose column value is below threshold;
+// returns how many rows were cleared
+inline size_t clearWhereLess(BitColumn& rows, const double* column, double threshold) {
+    size_t cleared = 0;
+    size_t fullWords = rows.size() / 64;
+    for (size_t w = 0; w < rows.wordCount(); w++) {
+        uint64_t& bits = rows.word(w);
+        if (bits == 0) continue;
+        uint64_t less = 0;
+        if (w < fullWords) {
+            less = lessMask64(column + w * 64, threshold);
+        } else {
+            for (size_t j = 0; w * 64 + j < rows.size(); j++) less |= (uint64_t)(column[w * 64 + j] < threshold) << j;
+        }
+        less &= bits;
+        cleared += (size_t)countBits(less);
+        bits &= ~less;
+    }
+    return cleared;
+}
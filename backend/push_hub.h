@@ -0,0 +1,96 @@
+// Room event fan-out
+//
+// Clients subscribe to a room with GET /events?room=NAME and keep the response
+// open as a Server-Sent Events stream. Light changes, eliminations and broken
+// bridge panels are serialized once into an immutable frame; every
+// subscriber's connection queues a reference to that same frame, so fanning
+// out to a full room costs one allocation no matter how many players watch.
+//
+// Subscribers live in the event loop that accepted them. The hub only records
+// which loops have at least one subscriber in a room, so a publisher can hand
+// the frame to exactly those loops; each loop keeps its own room -> connection
+// lists and never shares them.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "http_response.h"
+
+// One serialized "event: NAME\ndata: {...}\n\n" record
+using PushFrame = std::shared_ptr<const std::string>;
+
+// Frame for event `name` whose data is the JSON object fill(JsonWriter&) writes
+template <size_t N, typename F>
+PushFrame makePushFrame(const char (&name)[N], F&& fill) {
+    auto frame = std::make_shared<std::string>();
+    frame->reserve(128);
+    frame->append("event: ");
+    frame->append(name, N - 1);
+    frame->append("\ndata: ");
+    JsonWriter json(*frame);
+    json.beginObject();
+    fill(json);
+    json.endObject();
+    frame->append("\n\n");
+    return frame;
+}
+
+class PushHub {
+private:
+    // Loops 0-62 get a bit each; the rest share bit 63, counted so it clears
+    // only when the last of them leaves
+    static const int SHARED_BIT = 63;
+
+    struct Listeners {
+        uint64_t bits = 0;
+        uint32_t sharedCount = 0;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex lock;
+        std::unordered_map<uint64_t, Listeners> rooms;
+    };
+
+    static const size_t SHARD_COUNT = 64;
+
+    Shard shards[SHARD_COUNT];
+
+    Shard& shardFor(uint64_t room) { return shards[room & (SHARD_COUNT - 1)]; }
+
+public:
+    static uint64_t loopBit(int loop) { return 1ull << (loop < SHARED_BIT ? loop : SHARED_BIT); }
+
+    // The loop's first subscriber in the room arrived
+    void join(uint64_t room, int loop) {
+        Shard& shard = shardFor(room);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        Listeners& listeners = shard.rooms[room];
+        listeners.bits |= loopBit(loop);
+        if (loop >= SHARED_BIT) listeners.sharedCount++;
+    }
+
+    // The loop's last subscriber in the room left
+    void leave(uint64_t room, int loop) {
+        Shard& shard = shardFor(room);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.rooms.find(room);
+        if (it == shard.rooms.end()) return;
+        Listeners& listeners = it->second;
+        if (loop < SHARED_BIT || --listeners.sharedCount == 0) listeners.bits &= ~loopBit(loop);
+        if (!listeners.bits) shard.rooms.erase(it);
+    }
+
+    // Bits of the loops with subscribers in the room; 0 if nobody listens.
+    // A loop that gets a frame for a room it no longer serves drops it.
+    uint64_t loopsFor(uint64_t room) {
+        Shard& shard = shardFor(room);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.rooms.find(room);
+        return it == shard.rooms.end() ? 0 : it->second.bits;
+    }
+};
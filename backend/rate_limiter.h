@@ -0,0 +1,106 @@
+// Per-client token buckets
+//
+// Each client IPv4 address gets a bucket that holds up to `burst` tokens and
+// refills at `rate` tokens per second. A request takes one token, and a
+// request that finds the bucket empty is refused. Event loops on every
+// thread share the table, so a client cannot get around its limit by
+// spreading connections over workers.
+//
+// A bucket is one 64-bit word: a 16-bit tag taken from the address hash, the
+// millisecond it last refilled, and its tokens in 1/16ths. It is updated with
+// a compare-and-swap, so there are no locks and no allocation after
+// construction. An address hashes to a group of four slots in one cache line.
+// When all four belong to other clients, the slot refilled longest ago is
+// taken over. That bucket would be full by now anyway, so the client that
+// lost it starts again with a full bucket. Two addresses whose hashes agree
+// in group and tag share a bucket. With the default 64K slots (512 KB)
+// that needs one address in 64K per group, across clients active at once.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+class RateLimiter {
+public:
+    static constexpr uint32_t MAX_BURST = 4095; // tokens fit 16 bits in 1/16ths
+
+private:
+    static const uint64_t ONE = 16; // one token
+    static const unsigned GROUP = 4;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    size_t mask = 0;   // slot count - 1
+    uint32_t rate = 0; // tokens per second
+    uint32_t burst = 0;
+
+    static uint64_t pack(uint64_t tag, uint32_t stampMs, uint64_t tokens) {
+        return (tag << 48) | ((uint64_t)stampMs << 16) | tokens;
+    }
+    static uint64_t tagOf(uint64_t slot) { return slot >> 48; }
+    static uint32_t stampOf(uint64_t slot) { return (uint32_t)(slot >> 16); }
+    static uint64_t tokensOf(uint64_t slot) { return slot & 0xFFFF; }
+
+public:
+    // slotCount is rounded up to a power of two; rate 0 disables the limiter.
+    // burstTokens is kept within [1, MAX_BURST]; the server rejects larger
+    // --rate-burst values before getting here.
+    RateLimiter(uint32_t tokensPerSecond, uint32_t burstTokens, size_t slotCount = 64 * 1024)
+        : rate(tokensPerSecond), burst(burstTokens < 1 ? 1 : burstTokens > MAX_BURST ? MAX_BURST : burstTokens) {
+        if (!rate) return;
+        size_t count = GROUP;
+        while (count < slotCount) count <<= 1;
+        slots.reset(new std::atomic<uint64_t>[count]);
+        for (size_t i = 0; i < count; i++) slots[i].store(0, std::memory_order_relaxed);
+        mask = count - 1;
+    }
+
+    bool enabled() const { return rate != 0; }
+
+    // Take a token for the client; nowMs is any millisecond clock. When the
+    // bucket is empty, returns false and the whole seconds until a token is back.
+    bool allow(uint32_t address, uint32_t nowMs, uint32_t& retryAfterSec) {
+        if (!rate) return true;
+        uint64_t h = (address + 1) * 0x9E3779B97F4A7C15ull;
+        uint64_t tag = (h >> 48) | 1; // never 0, which marks an empty slot
+        size_t group = (size_t)(h >> 16) & mask & ~(size_t)(GROUP - 1);
+
+        while (true) {
+            // The client's slot, else an empty one, else the one idle longest
+            size_t index = group;
+            uint64_t current = slots[group].load(std::memory_order_relaxed);
+            bool found = false;
+            for (unsigned i = 0; i < GROUP; i++) {
+                uint64_t slot = slots[group + i].load(std::memory_order_relaxed);
+                if (tagOf(slot) == tag) {
+                    index = group + i;
+                    current = slot;
+                    found = true;
+                    break;
+                }
+                bool better = tagOf(current) != 0 &&
+                              (tagOf(slot) == 0 || (int32_t)(stampOf(slot) - stampOf(current)) < 0);
+                if (i > 0 && better) {
+                    index = group + i;
+                    current = slot;
+                }
+            }
+
+            uint64_t tokens = burst * ONE;
+            uint32_t stamp = nowMs;
+            if (found) {
+                tokens = tokensOf(current);
+                int32_t elapsed = (int32_t)(nowMs - stampOf(current));
+                uint64_t added = elapsed > 0 ? (uint64_t)elapsed * rate * ONE / 1000 : 0;
+                if (added == 0) stamp = stampOf(current); // keep the fraction of a 1/16th for next time
+                tokens = tokens + added < burst * ONE ? tokens + added : burst * ONE;
+            }
+            bool allowed = tokens >= ONE;
+            if (allowed) tokens -= ONE;
+            if (slots[index].compare_exchange_weak(current, pack(tag, stamp, tokens), std::memory_order_relaxed)) {
+                if (!allowed) retryAfterSec = (uint32_t)(((ONE - tokens) * 1000 + rate * ONE - 1) / (rate * ONE) + 999) / 1000;
+                return allowed;
+            }
+        }
+    }
+};
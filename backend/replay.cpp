@@ -0,0 +1,262 @@
+// Room journal replay
+//
+// Rebuilds room state from a journal written by `backend --journal=PATH`
+// (see journal.h), optionally starting from the PATH.snap snapshot, and checks
+// every recorded outcome against the game code. The journal is streamed in
+// 1 MB chunks, and entries for rooms that were not asked for are skipped
+// without being decoded.
+//
+// Build from backend/: g++ -std=c++17 -O2 replay.cpp games.cpp -o replay
+// Usage: replay JOURNAL [--snapshot[=PATH]] [--room=NAME | --key=HEX] [--list]
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "games.h"
+#include "journal.h"
+
+using namespace std;
+
+struct ReplayStats {
+    uint64_t entries = 0;
+    uint64_t applied = 0;
+    uint64_t mismatches = 0;
+    uint64_t missing = 0; // sequence numbers absent from the journal
+};
+
+class Replayer {
+private:
+    unordered_map<uint64_t, RoomState> records;
+    unordered_set<uint64_t> runsOfRoom; // with a room filter: the runs started in it
+    uint64_t onlyRoom = 0;              // 0 = every room
+    bool fromSnapshot = false;
+    uint64_t marks[SessionStore::SHARD_COUNT] = {};
+    ReplayStats stats;
+
+    void mismatch(const JournalEntry& e, const char* what) {
+        stats.mismatches++;
+        if (stats.mismatches <= 20) {
+            fprintf(stderr, "seq %" PRIu64 " key %016" PRIx64 ": %s does not match the journal\n", e.seq, e.key, what);
+        }
+    }
+
+    bool wanted(const JournalEntry& e) {
+        if (!onlyRoom) return true;
+        if (e.kind == JournalKind::RunStart && e.arg == onlyRoom) runsOfRoom.insert(e.key);
+        return e.key == onlyRoom || runsOfRoom.count(e.key);
+    }
+
+    void apply(const JournalEntry& e) {
+        // Entries the snapshot already reflects
+        if (fromSnapshot && e.seq < marks[SessionStore::shardOf(e.key)]) return;
+        stats.applied++;
+
+        if (e.kind == JournalKind::Created) {
+            RoomState fresh;
+            fresh.seed = e.arg;
+            records[e.key] = fresh;
+            return;
+        }
+        RoomState& state = records[e.key];
+        switch (e.kind) {
+            case JournalKind::LightOn:
+                RedLightGreenLightGame::switchOn(state);
+                if (state.light != e.a) mismatch(e, "light");
+                break;
+            case JournalKind::LightFlip:
+                RedLightGreenLightGame::flipLight(state);
+                if (state.light != e.a) mismatch(e, "light");
+                break;
+            case JournalKind::LightOff:
+                state.light = LIGHT_OFF;
+                break;
+            case JournalKind::RunStart:
+                RedLightGreenLightGame::startRun(state);
+                if (state.runEpoch != e.x) mismatch(e, "run epoch");
+                break;
+            case JournalKind::RunExpired:
+                if (state.runEpoch == e.x) state.runExpired = true;
+                else mismatch(e, "run epoch");
+                break;
+            case JournalKind::RedLight: {
+                if (state.light != e.b) mismatch(e, "light"); // judged under the room's lock
+                RedLightResult r = (e.flags & JournalEntry::EXPIRED)
+                                       ? RedLightGreenLightGame::timeUp((RoomLight)e.b, e.x)
+                                       : RedLightGreenLightGame::processAction((RoomLight)e.b, (RedLightAction)e.a, e.x);
+                if (r.position != e.result || r.survived != ((e.flags & JournalEntry::SURVIVED) != 0)) mismatch(e, "red light outcome");
+                break;
+            }
+            case JournalKind::GlassBridge: {
+                if (e.x < 0 || e.x >= BRIDGE_STEPS) {
+                    mismatch(e, "bridge step");
+                    break;
+                }
+                GlassBridgeResult r = GlassBridgeGame::processChoice(state, (Panel)e.a, e.x);
+                if ((uint8_t)r.correctChoice != e.b || r.survived != ((e.flags & JournalEntry::SURVIVED) != 0)) {
+                    mismatch(e, "glass bridge outcome");
+                }
+                break;
+            }
+            case JournalKind::BridgeReset:
+                GlassBridgeGame::resetBridge(state, e.arg);
+                break;
+            case JournalKind::TugOfWar: {
+                Rng rng = state.nextRng();
+                TugOfWarResult r = TugOfWarGame::processPull(rng, e.x, e.y, e.z, (TugStrategy)e.a);
+                if (r.playerStrength != e.result || r.survived != ((e.flags & JournalEntry::SURVIVED) != 0)) {
+                    mismatch(e, "tug of war outcome");
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+public:
+    explicit Replayer(uint64_t room) : onlyRoom(room) {}
+
+    const ReplayStats& result() const { return stats; }
+    const unordered_map<uint64_t, RoomState>& state() const { return records; }
+    uint64_t room() const { return onlyRoom; }
+    bool isRunOfRoom(uint64_t key) const { return runsOfRoom.count(key) != 0; }
+
+    bool loadSnapshot(const string& path) {
+        FILE* in = fopen(path.c_str(), "rb");
+        if (!in) return false;
+        SnapshotHeader header;
+        bool ok = fread(&header, sizeof(header), 1, in) == 1 && memcmp(header.magic, SnapshotHeader().magic, 8) == 0;
+        vector<SnapshotRoom> batch(4096);
+        uint64_t left = ok ? header.rooms : 0;
+        while (ok && left > 0) {
+            size_t want = left < batch.size() ? (size_t)left : batch.size();
+            size_t got = fread(batch.data(), sizeof(SnapshotRoom), want, in);
+            for (size_t i = 0; i < got; i++) {
+                // Runs cannot be tied to their room from the snapshot alone
+                if (!onlyRoom || batch[i].key == onlyRoom) records[batch[i].key] = batch[i].state;
+            }
+            ok = got == want;
+            left -= got;
+        }
+        fclose(in);
+        if (ok) {
+            memcpy(marks, header.marks, sizeof(marks));
+            fromSnapshot = true;
+        }
+        return ok;
+    }
+
+    // Stream the journal; false if it cannot be read or is not a journal
+    bool run(const string& path) {
+        FILE* in = fopen(path.c_str(), "rb");
+        if (!in) return false;
+        vector<JournalEntry> chunk((1 << 20) / sizeof(JournalEntry));
+        uint64_t expected = 0;
+        bool first = true;
+        while (size_t got = fread(chunk.data(), sizeof(JournalEntry), chunk.size(), in)) {
+            for (size_t i = 0; i < got; i++) {
+                const JournalEntry& e = chunk[i];
+                if (first) {
+                    first = false;
+                    if (e.kind != JournalKind::Start || e.seq != 0) {
+                        fclose(in);
+                        return false;
+                    }
+                    expected = 1;
+                    continue;
+                }
+                stats.entries++;
+                if (e.seq > expected) stats.missing += e.seq - expected;
+                expected = e.seq + 1;
+                if (wanted(e)) apply(e);
+            }
+        }
+        fclose(in);
+        return !first;
+    }
+};
+
+static void printRoom(uint64_t key, const RoomState& s, const char* label) {
+    static const char* const lights[] = {"OFF", "GREEN", "RED"};
+    printf("%s %016" PRIx64 ": seed=%016" PRIx64 " draws=%u light=%s", label, key, s.seed, s.draws,
+           s.light <= LIGHT_RED ? lights[s.light] : "?");
+    if (s.brokenPanels) {
+        printf(" broken=");
+        for (int step = 0; step < BRIDGE_STEPS; step++) {
+            for (int panel = 0; panel < 2; panel++) {
+                if (s.isBroken(step, panel)) printf("%d%c ", step, panel ? 'R' : 'L');
+            }
+        }
+    }
+    if (s.runEpoch) printf(" run=%u%s", s.runEpoch, s.runExpired ? " (expired)" : "");
+    printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+    static const char* const USAGE = "Usage: replay JOURNAL [--snapshot[=PATH]] [--room=NAME | --key=HEX | --list]\n";
+    if (argc < 2) {
+        fprintf(stderr, "%s", USAGE);
+        return 2;
+    }
+    string journalPath = argv[1];
+    string snapshotPath;
+    uint64_t room = 0;
+    bool list = false;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--snapshot") snapshotPath = journalPath + ".snap";
+        else if (arg.rfind("--snapshot=", 0) == 0) snapshotPath = arg.substr(11);
+        else if (arg.rfind("--room=", 0) == 0) room = roomKey(arg.substr(7));
+        else if (arg.rfind("--key=", 0) == 0) room = strtoull(arg.c_str() + 6, nullptr, 16);
+        else if (arg == "--list") list = true;
+        else {
+            fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+    if (room && list) {
+        // --room replays only that room, so there would be nothing else to list
+        fprintf(stderr, "--list cannot be combined with --room or --key\n%s", USAGE);
+        return 2;
+    }
+
+    Replayer replayer(room);
+    auto started = chrono::steady_clock::now();
+    if (!snapshotPath.empty() && !replayer.loadSnapshot(snapshotPath)) {
+        fprintf(stderr, "Cannot read snapshot %s\n", snapshotPath.c_str());
+        return 1;
+    }
+    if (!replayer.run(journalPath)) {
+        fprintf(stderr, "Cannot read journal %s\n", journalPath.c_str());
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    const ReplayStats& stats = replayer.result();
+    printf("%" PRIu64 " entries, %" PRIu64 " applied, %zu records rebuilt in %.3f s (%.1f M entries/s)\n", stats.entries,
+           stats.applied, replayer.state().size(), seconds, seconds > 0 ? (double)stats.entries / seconds / 1e6 : 0.0);
+    if (stats.missing) printf("%" PRIu64 " entries missing from the journal (dropped under load)\n", stats.missing);
+    printf("%" PRIu64 " mismatches\n", stats.mismatches);
+
+    if (room) {
+        auto it = replayer.state().find(room);
+        if (it == replayer.state().end()) printf("room %016" PRIx64 " not found\n", room);
+        else printRoom(room, it->second, "room");
+        for (auto& record : replayer.state()) {
+            // A run draws nothing, so only its epoch matters
+            if (replayer.isRunOfRoom(record.first)) {
+                printf("  run %016" PRIx64 ": epoch=%u%s\n", record.first, record.second.runEpoch,
+                       record.second.runExpired ? " (expired)" : "");
+            }
+        }
+    } else if (list) {
+        for (auto& record : replayer.state()) printRoom(record.first, record.second, "record");
+    }
+    return stats.mismatches ? 1 : 0;
+}
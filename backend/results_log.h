@@ -0,0 +1,230 @@
+// Durable game results
+//
+// Every finished run (a player shot, fallen or done pulling) becomes one
+// 64-byte ResultRecord appended to a log file. The file is grown in 1 MB
+// steps and mapped with mmap, so an append is a memcpy into the mapping and
+// durability is one msync over the bytes added since the last sync, however
+// many records that covers. The zero-filled space past the last record is
+// never a valid record (its check field is 0), so reopening the log finds the
+// end by scanning forward; a record torn by a crash fails its checksum and is
+// overwritten by the next append.
+//
+// The log has a single writer. open() takes an exclusive lock on the file,
+// so the server and the console game cannot interleave records.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#include "keyword_table.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define SQUID_HAVE_MMAP 1
+#endif
+
+enum class ResultGame : uint8_t { RedLight, GlassBridge, TugOfWar, Count };
+
+inline const char* resultGameName(ResultGame game) {
+    static const char* const names[] = {"redlight", "glassbridge", "tugofwar"};
+    return game < ResultGame::Count ? names[(int)game] : "";
+}
+
+inline ResultGame parseResultGame(std::string_view name) {
+    static constexpr Keyword<ResultGame> words[] = {
+        {"redlight", ResultGame::RedLight}, {"glassbridge", ResultGame::GlassBridge}, {"tugofwar", ResultGame::TugOfWar}};
+    static constexpr auto table = makeKeywordTable(words, ResultGame::Count);
+    static_assert(table.perfect, "no collision-free seed for the game names");
+    return table.lookup(name);
+}
+
+struct ResultRecord {
+    uint64_t timeMs = 0;   // Unix time of the result
+    uint32_t score = 0;    // game-specific progress: position, step or strength
+    uint32_t check = 0;    // checksum of the other fields, never 0 in a written record
+    uint8_t game = 0;      // ResultGame
+    uint8_t survived = 0;
+    uint8_t nameLength = 0;
+    uint8_t reserved = 0;
+    char name[44] = {};    // player name, UTF-8, truncated on a character boundary
+
+    std::string_view playerName() const { return std::string_view(name, nameLength); }
+
+    uint32_t checksum() const {
+        ResultRecord copy = *this;
+        copy.check = 0;
+        const unsigned char* bytes = (const unsigned char*)&copy;
+        uint64_t h = 0xCBF29CE484222325ull; // FNV-1a
+        for (size_t i = 0; i < sizeof(copy); i++) {
+            h ^= bytes[i];
+            h *= 0x100000001B3ull;
+        }
+        uint32_t folded = (uint32_t)(h ^ (h >> 32));
+        return folded ? folded : 1;
+    }
+
+    bool valid() const { return check != 0 && check == checksum() && game < (uint8_t)ResultGame::Count; }
+};
+static_assert(sizeof(ResultRecord) == 64, "results are fixed 64-byte records");
+
+inline ResultRecord makeResult(ResultGame game, std::string_view playerName, uint32_t score, bool survived) {
+    ResultRecord r;
+    r.timeMs = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch()).count();
+    r.score = score;
+    r.game = (uint8_t)game;
+    r.survived = survived ? 1 : 0;
+    size_t n = playerName.size() < sizeof(r.name) ? playerName.size() : sizeof(r.name);
+    // Do not cut a multi-byte character in half
+    if (n < playerName.size()) {
+        while (n > 0 && ((unsigned char)playerName[n] & 0xC0) == 0x80) n--;
+    }
+    memcpy(r.name, playerName.data(), n);
+    r.nameLength = (uint8_t)n;
+    return r;
+}
+
+class ResultsLog {
+private:
+    static const size_t GROW_BYTES = 1 << 20;
+
+    int fd = -1;
+    char* map = nullptr;
+    size_t mapped = 0; // bytes of the file, all mapped
+    size_t count = 0;  // valid records at the front
+    size_t synced = 0; // records known to be on disk
+
+    ResultRecord* records() const { return (ResultRecord*)map; }
+
+#ifdef SQUID_HAVE_MMAP
+    bool remap(size_t bytes, std::string& error) {
+        if (map) munmap(map, mapped);
+        map = nullptr;
+        mapped = 0;
+        if (ftruncate(fd, (off_t)bytes) != 0) {
+            error = std::string("ftruncate: ") + strerror(errno);
+            return false;
+        }
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            error = std::string("mmap: ") + strerror(errno);
+            return false;
+        }
+        map = (char*)p;
+        mapped = bytes;
+        return true;
+    }
+#endif
+
+public:
+    ResultsLog() = default;
+    ResultsLog(const ResultsLog&) = delete;
+    ResultsLog& operator=(const ResultsLog&) = delete;
+    ~ResultsLog() { close(); }
+
+    bool isOpen() const { return map != nullptr; }
+    size_t size() const { return count; }
+    const ResultRecord& operator[](size_t i) const { return records()[i]; }
+
+    // Open or create the log and find its end. Returns false with a reason
+    // if the file cannot be used, including when another process holds it.
+    bool open(const std::string& path, std::string& error) {
+#ifdef SQUID_HAVE_MMAP
+        close();
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            error = path + ": " + strerror(errno);
+            return false;
+        }
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            error = path + ": in use by another process";
+            close();
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            error = path + ": " + strerror(errno);
+            close();
+            return false;
+        }
+        // Whole records only; a file cut short mid-record loses that record
+        size_t bytes = (size_t)st.st_size / sizeof(ResultRecord) * sizeof(ResultRecord);
+        if (!remap(bytes < GROW_BYTES ? GROW_BYTES : bytes, error)) {
+            error = path + ": " + error;
+            close();
+            return false;
+        }
+        size_t capacity = mapped / sizeof(ResultRecord);
+        count = 0;
+        while (count < capacity && records()[count].valid()) count++;
+        synced = count;
+        return true;
+#else
+        (void)path;
+        error = "results log needs mmap";
+        return false;
+#endif
+    }
+
+    // Copy records to the end of the log, growing the file as needed. They
+    // are durable once sync() returns.
+    bool append(const ResultRecord* batch, size_t n, std::string& error) {
+#ifdef SQUID_HAVE_MMAP
+        if (!map) return false;
+        size_t need = (count + n) * sizeof(ResultRecord);
+        if (need > mapped) {
+            size_t bytes = mapped;
+            while (bytes < need) bytes += GROW_BYTES;
+            if (!remap(bytes, error)) return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            ResultRecord& r = records()[count + i];
+            r = batch[i];
+            r.check = r.checksum();
+        }
+        count += n;
+        return true;
+#else
+        (void)batch, (void)n, (void)error;
+        return false;
+#endif
+    }
+
+    // Flush everything appended since the last sync with one msync
+    bool sync() {
+#ifdef SQUID_HAVE_MMAP
+        if (!map || synced == count) return true;
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t from = synced * sizeof(ResultRecord) / page * page;
+        size_t to = count * sizeof(ResultRecord);
+        if (msync(map + from, to - from, MS_SYNC) != 0) return false;
+        synced = count;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void close() {
+#ifdef SQUID_HAVE_MMAP
+        if (map) {
+            sync();
+            munmap(map, mapped);
+        }
+        if (fd >= 0) ::close(fd); // releases the lock
+#endif
+        map = nullptr;
+        mapped = 0;
+        count = synced = 0;
+        fd = -1;
+    }
+};
@@ -0,0 +1,182 @@
+// Random number generation shared by the HTTP backend and the console game
+//
+// Every thread gets its own generator (threadRng), so game logic on different
+// worker threads never contends on shared state the way rand() does. The
+// generators are small value types: a session can own one seeded from a
+// known value and replay exactly the same sequence later.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <thread>
+
+// SplitMix64 step; used to expand one 64-bit seed into generator state and
+// as a cheap stateless hash
+inline uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t mixSeed(uint64_t seed, uint64_t value) {
+    uint64_t state = seed ^ (value * 0xD1B54A32D192ED03ull);
+    return splitMix64(state);
+}
+
+// xoshiro256** (Blackman & Vigna): 32 bytes of state, a few cycles per draw
+class Xoshiro256ss {
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    using result_type = uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~(result_type)0; }
+
+    explicit Xoshiro256ss(uint64_t seed = 0x5EEDull) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        for (uint64_t& word : s) word = splitMix64(seed);
+    }
+
+    result_type operator()() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+};
+
+// PCG32 (O'Neill): 16 bytes of state, 32-bit output
+class Pcg32 {
+private:
+    uint64_t state;
+    uint64_t inc;
+
+public:
+    using result_type = uint32_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~(result_type)0; }
+
+    explicit Pcg32(uint64_t seed = 0x5EEDull, uint64_t stream = 0) { reseed(seed, stream); }
+
+    void reseed(uint64_t seed, uint64_t stream = 0) {
+        state = 0;
+        inc = (stream << 1) | 1;
+        (*this)();
+        state += seed;
+        (*this)();
+    }
+
+    result_type operator()() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ull + inc;
+        uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rot = (uint32_t)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+};
+
+// Game-facing helpers over any engine. Coin flips are served from a cached
+// 64-bit word, so 64 flips cost one engine call.
+template <typename Engine>
+class BasicRng {
+private:
+    Engine engine;
+    uint64_t bits = 0;
+    int bitsLeft = 0;
+
+    uint32_t next32() { return (uint32_t)engine(); }
+
+public:
+    using result_type = typename Engine::result_type;
+    static constexpr result_type min() { return Engine::min(); }
+    static constexpr result_type max() { return Engine::max(); }
+
+    explicit BasicRng(uint64_t seed) : engine(seed) {}
+
+    // Restart the sequence; the same seed always yields the same draws
+    void reseed(uint64_t seed) {
+        engine.reseed(seed);
+        bitsLeft = 0;
+    }
+
+    // Lets std:: distributions draw from this generator
+    result_type operator()() { return engine(); }
+
+    bool coin() {
+        if (bitsLeft == 0) {
+            // Two statements: the operands of | may be evaluated in either order
+            uint64_t hi = next32();
+            uint64_t lo = next32();
+            bits = (hi << 32) | lo;
+            bitsLeft = 64;
+        }
+        bool bit = bits & 1;
+        bits >>= 1;
+        bitsLeft--;
+        return bit;
+    }
+
+    // Uniform in [0, n) via Lemire's multiply-shift, no modulo bias
+    uint32_t below(uint32_t n) {
+        uint64_t m = (uint64_t)next32() * n;
+        uint32_t low = (uint32_t)m;
+        if (low < n) {
+            uint32_t threshold = (0u - n) % n;
+            while (low < threshold) {
+                m = (uint64_t)next32() * n;
+                low = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
+
+    // Uniform in [lo, hi]
+    int between(int lo, int hi) { return lo + (int)below((uint32_t)(hi - lo + 1)); }
+
+    // True with probability percent/100
+    bool chance(int percent) { return (int)below(100) < percent; }
+
+    // Uniform in [0, 1). The draws are sequenced so every compiler gets the
+    // same double from the same seed.
+    double unit() {
+        uint64_t hi = next32();
+        uint64_t lo = next32();
+        return (double)((hi << 21) ^ (lo >> 11)) * (1.0 / 9007199254740992.0);
+    }
+};
+
+using Rng = BasicRng<Xoshiro256ss>;
+
+// Fresh seed for a new thread or session: OS entropy mixed with the clock and
+// a process-wide counter, so two threads started together still differ
+inline uint64_t freshSeed() {
+    static std::atomic<uint64_t> counter{0};
+    static const uint64_t processEntropy = []() {
+        std::random_device device;
+        return ((uint64_t)device() << 32) ^ device();
+    }();
+    uint64_t clock = (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    uint64_t state = processEntropy ^ clock ^ (counter.fetch_add(1, std::memory_order_relaxed) << 48);
+    return splitMix64(state);
+}
+
+// This thread's generator
+inline Rng& threadRng() {
+    thread_local Rng rng(freshSeed());
+    return rng;
+}
+
+// Make this thread's draws reproducible (e.g. to replay a console session)
+inline void seedThreadRng(uint64_t seed) { threadRng().reseed(seed); }
@@ -0,0 +1,264 @@
+// Per-room game state
+//
+// Every request names a room (the JSON "room" field; rooms that are not named
+// share the default room). State lives in a fixed-capacity table split into
+// independently locked shards, so requests for different rooms rarely touch
+// the same lock, and memory is bounded by the configured room limit no matter
+// how many room names clients invent. The event loop that creates a room arms
+// a timer for its TTL and calls expireIfIdle when it fires, so idle rooms are
+// evicted without scanning the table; when a shard is full the stalest room
+// in it makes way.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <type_traits>
+
+#include "rng.h"
+
+const int BRIDGE_STEPS = 18;
+
+enum RoomLight : uint8_t { LIGHT_OFF, LIGHT_GREEN, LIGHT_RED };
+
+// 32-byte record per room. Red Light Green Light keeps the doll's light in the
+// room's record and each player's run in a record of its own (see runKey).
+struct RoomState {
+    uint64_t seed = 0;         // bridge layout and the room's random stream
+    uint64_t brokenPanels = 0; // bit 2*step + panel (0=left, 1=right)
+    uint32_t draws = 0;        // random draws taken from the room's stream
+    uint32_t lastSeen = 0;     // coarse seconds, for TTL eviction
+    uint32_t id = 0;           // unique per record; timers carry it so a reused key is not mistaken for the old room
+    uint16_t runEpoch = 0;     // bumped when a run starts, so the previous run's deadline is ignored
+    uint8_t light = LIGHT_OFF; // off until the room's light timer is armed
+    bool runExpired = false;   // the run's deadline has passed
+
+    bool isBroken(int step, int panel) const { return (brokenPanels >> (step * 2 + panel)) & 1; }
+    void breakPanel(int step, int panel) { brokenPanels |= 1ull << (step * 2 + panel); }
+
+    // Next generator from the room's stream. A room replays identically from
+    // its seed because the stream position, not the clock, picks the draws.
+    Rng nextRng() { return Rng(mixSeed(seed, draws++)); }
+};
+
+// Rooms are keyed by a 64-bit hash of their name; 0 marks an empty slot
+inline uint64_t roomKey(std::string_view name) {
+    uint64_t h = 0xCBF29CE484222325ull; // FNV-1a
+    for (char c : name) {
+        h ^= (unsigned char)c;
+        h *= 0x100000001B3ull;
+    }
+    h = splitMix64(h);
+    return h ? h : 1;
+}
+
+// One player's Red Light run within a room
+inline uint64_t runKey(uint64_t room, std::string_view playerName) {
+    uint64_t h = mixSeed(room, roomKey(playerName));
+    return h ? h : 1;
+}
+
+inline uint32_t coarseNowSeconds() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<seconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+class SessionStore {
+public:
+    static const size_t SHARD_COUNT = 64;
+
+    // Shards are chosen by the low bits of the key
+    static size_t shardOf(uint64_t key) { return (size_t)(key & (SHARD_COUNT - 1)); }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        RoomState state;
+    };
+
+    // Open addressing with linear probing; deletions shift the following
+    // cluster back so no tombstones accumulate
+    struct alignas(64) Shard {
+        std::mutex lock;
+        std::unique_ptr<Slot[]> slots;
+        size_t mask = 0;
+        size_t count = 0;
+    };
+
+    Shard shards[SHARD_COUNT];
+    size_t roomsPerShard;
+    uint32_t ttlSeconds;
+    std::atomic<uint32_t> nextId{1};
+
+    static size_t slotIndex(uint64_t key) { return (size_t)(key >> 6); }
+    static Shard& shardFor(Shard* all, uint64_t key) { return all[shardOf(key)]; }
+
+    // Remove slot i and close the gap it leaves in its probe cluster
+    static void eraseAt(Shard& shard, size_t i) {
+        size_t hole = i;
+        size_t j = i;
+        while (true) {
+            j = (j + 1) & shard.mask;
+            if (shard.slots[j].key == 0) break;
+            size_t home = slotIndex(shard.slots[j].key) & shard.mask;
+            // Move j into the hole unless its home lies cyclically in (hole, j]
+            bool homeBetween = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+            if (!homeBetween) {
+                shard.slots[hole] = shard.slots[j];
+                hole = j;
+            }
+        }
+        shard.slots[hole].key = 0;
+        shard.count--;
+    }
+
+    size_t evictExpired(Shard& shard, uint32_t now) {
+        size_t evicted = 0;
+        for (size_t i = 0; i <= shard.mask;) {
+            Slot& slot = shard.slots[i];
+            if (slot.key != 0 && now - slot.state.lastSeen >= ttlSeconds) {
+                eraseAt(shard, i); // a shifted entry may now sit at i; look again
+                evicted++;
+            } else {
+                i++;
+            }
+        }
+        return evicted;
+    }
+
+    void evictStalest(Shard& shard) {
+        size_t stalest = 0;
+        uint32_t oldest = UINT32_MAX;
+        for (size_t i = 0; i <= shard.mask; i++) {
+            if (shard.slots[i].key != 0 && shard.slots[i].state.lastSeen < oldest) {
+                oldest = shard.slots[i].state.lastSeen;
+                stalest = i;
+            }
+        }
+        eraseAt(shard, stalest);
+    }
+
+    // Caller holds shard.lock; created is set if the room is new
+    RoomState& findOrCreate(Shard& shard, uint64_t key, uint32_t now, bool& created) {
+        size_t i = slotIndex(key) & shard.mask;
+        while (shard.slots[i].key != 0) {
+            if (shard.slots[i].key == key) return shard.slots[i].state;
+            i = (i + 1) & shard.mask;
+        }
+
+        if (shard.count >= roomsPerShard) {
+            if (evictExpired(shard, now) == 0) evictStalest(shard);
+            return findOrCreate(shard, key, now, created); // probe again; the table changed
+        }
+
+        Slot& slot = shard.slots[i];
+        slot.key = key;
+        slot.state = RoomState();
+        slot.state.seed = freshSeed();
+        slot.state.id = nextId.fetch_add(1, std::memory_order_relaxed);
+        shard.count++;
+        created = true;
+        return slot.state;
+    }
+
+    // Caller holds shard.lock; nullptr if the key has no room
+    static RoomState* find(Shard& shard, uint64_t key) {
+        size_t i = slotIndex(key) & shard.mask;
+        while (shard.slots[i].key != 0) {
+            if (shard.slots[i].key == key) return &shard.slots[i].state;
+            i = (i + 1) & shard.mask;
+        }
+        return nullptr;
+    }
+
+public:
+    SessionStore(size_t maxRooms, uint32_t ttlSec) : ttlSeconds(ttlSec) {
+        roomsPerShard = maxRooms / SHARD_COUNT + 1;
+        // Keep every shard at most half full so probe chains stay short
+        size_t capacity = 16;
+        while (capacity < roomsPerShard * 2) capacity <<= 1;
+        for (Shard& shard : shards) {
+            shard.slots.reset(new Slot[capacity]);
+            shard.mask = capacity - 1;
+        }
+    }
+
+    uint32_t ttl() const { return ttlSeconds; }
+
+    // Run fn(RoomState&) with the room locked, creating the room on first use.
+    // Returns true if this call created the room; fn(RoomState&, bool created)
+    // learns it while the lock is still held.
+    template <typename F>
+    bool withRoom(uint64_t key, F&& fn) {
+        uint32_t now = coarseNowSeconds();
+        Shard& shard = shardFor(shards, key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        bool created = false;
+        RoomState& room = findOrCreate(shard, key, now, created);
+        room.lastSeen = now;
+        if constexpr (std::is_invocable_v<F&, RoomState&, bool>) fn(room, created);
+        else fn(room);
+        return created;
+    }
+
+    // Run fn(RoomState&) only if the room still holds record `id`; timers use
+    // this so they neither resurrect an evicted room nor count as activity
+    template <typename F>
+    bool withExistingRoom(uint64_t key, uint32_t id, F&& fn) {
+        Shard& shard = shardFor(shards, key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        RoomState* room = find(shard, key);
+        if (!room || room->id != id) return false;
+        fn(*room);
+        return true;
+    }
+
+    // Called when a room's TTL timer fires. Evicts the room if it has been idle
+    // for the whole TTL and returns 0; otherwise returns the seconds left, for
+    // the caller to re-arm. A room already gone (or replaced) also returns 0.
+    uint32_t expireIfIdle(uint64_t key, uint32_t id) {
+        uint32_t now = coarseNowSeconds();
+        Shard& shard = shardFor(shards, key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        size_t i = slotIndex(key) & shard.mask;
+        while (shard.slots[i].key != 0 && shard.slots[i].key != key) i = (i + 1) & shard.mask;
+        Slot& slot = shard.slots[i];
+        if (slot.key != key || slot.state.id != id) return 0;
+        uint32_t idle = now - slot.state.lastSeen;
+        if (idle < ttlSeconds) return ttlSeconds - idle;
+        eraseAt(shard, i);
+        return 0;
+    }
+
+    // fn(key, const RoomState&) for every room, one shard at a time. mark(shard)
+    // runs first with that shard's lock held, so whatever it records is
+    // consistent with the rooms copied under the same lock. released(shard)
+    // runs once the lock is dropped, for slow work such as writing the copies
+    // out, which must not hold up requests on that shard.
+    template <typename Mark, typename F, typename Released>
+    void forEachRoom(Mark&& mark, F&& fn, Released&& released) {
+        for (size_t s = 0; s < SHARD_COUNT; s++) {
+            Shard& shard = shards[s];
+            {
+                std::lock_guard<std::mutex> guard(shard.lock);
+                mark(s);
+                for (size_t i = 0; i <= shard.mask; i++) {
+                    if (shard.slots[i].key != 0) fn(shard.slots[i].key, (const RoomState&)shard.slots[i].state);
+                }
+            }
+            released(s);
+        }
+    }
+
+    size_t roomCount() {
+        size_t total = 0;
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            total += shard.count;
+        }
+        return total;
+    }
+};
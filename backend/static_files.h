@@ -0,0 +1,265 @@
+// Frontend files served by the backend
+//
+// load() walks the frontend directory once at startup. Small files are kept
+// in memory and copied into the response buffer behind the headers. Files of
+// SENDFILE_MIN_BYTES or more (the images in assets/) stay open instead, and
+// the event loop sends them with sendfile, straight from the page cache.
+//
+// Every file gets a strong ETag (a hash of its bytes) and Cache-Control:
+// no-cache, so browsers revalidate and a matching If-None-Match costs a
+// bodiless 304. A NAME.gz or NAME.br next to NAME, produced ahead of time by
+// `gzip -k` or `brotli -k`, is served instead of NAME to clients that accept
+// that coding. A variant is only used if it is smaller and not older than
+// NAME. Files are not compressed here, so the server needs no zlib or brotli.
+//
+// The set of files is fixed once load() returns. Changes on disk show up
+// after a restart, and a request can only name a file that was loaded, so
+// paths like /../x never reach the filesystem.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "http_parser.h"
+
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <sys/sendfile.h>
+    #include <unistd.h>
+    #define SQUID_HAVE_SENDFILE 1
+#endif
+
+// One encoding of a file
+struct StaticBody {
+    std::string bytes;   // the body, unless it is sent from fd
+    int fd = -1;         // sendfile source; bytes is empty
+    size_t size = 0;
+    std::string etag;    // quoted
+    std::string headers; // ETag, Cache-Control and, with variants, Vary and Content-Encoding lines
+
+    bool present() const { return size > 0 || !etag.empty(); }
+};
+
+struct StaticFile {
+    enum Coding { IDENTITY, GZIP, BR, CODINGS };
+
+    std::string contentType;
+    StaticBody bodies[CODINGS];
+
+    // The smallest encoding the client accepts
+    const StaticBody& pick(uint8_t acceptEncoding) const {
+        if ((acceptEncoding & CODING_BR) && bodies[BR].present()) return bodies[BR];
+        if ((acceptEncoding & CODING_GZIP) && bodies[GZIP].present()) return bodies[GZIP];
+        return bodies[IDENTITY];
+    }
+};
+
+// The part of a file response still to be sent after the connection's
+// output buffer: `remaining` bytes of `fd` from `offset`
+struct FileSend {
+    int fd = -1;
+    int64_t offset = 0;
+    size_t remaining = 0;
+};
+
+class StaticFiles {
+public:
+    static const size_t SENDFILE_MIN_BYTES = 64 * 1024;
+
+private:
+    std::map<std::string, StaticFile, std::less<>> files; // by URL path, "/index.html"
+    size_t memoryBytes = 0;
+
+    static const char* contentTypeFor(std::string_view name) {
+        static const struct {
+            const char* extension;
+            const char* type;
+        } types[] = {
+            {".html", "text/html; charset=utf-8"},  {".js", "text/javascript; charset=utf-8"},
+            {".css", "text/css; charset=utf-8"},    {".json", "application/json"},
+            {".svg", "image/svg+xml"},              {".png", "image/png"},
+            {".jpg", "image/jpeg"},                 {".jpeg", "image/jpeg"},
+            {".webp", "image/webp"},                {".gif", "image/gif"},
+            {".ico", "image/x-icon"},               {".woff2", "font/woff2"},
+            {".txt", "text/plain; charset=utf-8"},  {".md", "text/markdown; charset=utf-8"},
+        };
+        for (const auto& t : types) {
+            std::string_view ext(t.extension);
+            if (name.size() >= ext.size() && name.compare(name.size() - ext.size(), ext.size(), ext) == 0) return t.type;
+        }
+        return "application/octet-stream";
+    }
+
+    static bool readFile(const std::filesystem::path& path, std::string& bytes) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return !in.bad();
+    }
+
+    static uint64_t hashBytes(std::string_view bytes) {
+        uint64_t h = 0xCBF29CE484222325ull; // FNV-1a
+        for (char c : bytes) {
+            h ^= (unsigned char)c;
+            h *= 0x100000001B3ull;
+        }
+        return h;
+    }
+
+    // Fill body from the file at path; large files are opened for sendfile
+    static bool loadBody(const std::filesystem::path& path, StaticBody& body, std::string_view etagSuffix) {
+        std::string bytes;
+        if (!readFile(path, bytes)) return false;
+        static const char hex[] = "0123456789abcdef";
+        uint64_t h = hashBytes(bytes);
+        body.etag = "\"";
+        for (int shift = 60; shift >= 0; shift -= 4) body.etag += hex[(h >> shift) & 0xF];
+        body.etag.append(etagSuffix.data(), etagSuffix.size());
+        body.etag += '"';
+        body.size = bytes.size();
+#ifdef SQUID_HAVE_SENDFILE
+        if (bytes.size() >= SENDFILE_MIN_BYTES) {
+            body.fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (body.fd >= 0) return true;
+        }
+#endif
+        body.bytes = std::move(bytes);
+        return true;
+    }
+
+    static bool isHidden(const std::filesystem::path& relative) {
+        for (const auto& part : relative) {
+            std::string name = part.string();
+            if (name.empty()) continue;
+            if (name[0] == '.' || name == "node_modules") return true;
+        }
+        return false;
+    }
+
+    static bool endsWith(std::string_view s, std::string_view suffix) {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+public:
+    StaticFiles() = default;
+    StaticFiles(const StaticFiles&) = delete;
+    StaticFiles& operator=(const StaticFiles&) = delete;
+
+    ~StaticFiles() {
+#ifdef SQUID_HAVE_SENDFILE
+        for (auto& entry : files) {
+            for (StaticBody& body : entry.second.bodies) {
+                if (body.fd >= 0) ::close(body.fd);
+            }
+        }
+#endif
+    }
+
+    size_t size() const { return files.size(); }
+    size_t bytesInMemory() const { return memoryBytes; }
+
+    // Load every file under root, except hidden ones and node_modules.
+    // Returns false with a reason if root cannot be read.
+    bool load(const std::string& root, std::string& error) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        if (!fs::is_directory(root, ec)) {
+            error = root + ": not a directory";
+            return false;
+        }
+        fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            std::error_code fileError; // a file that vanished mid-walk is skipped, not fatal
+            if (!it->is_regular_file(fileError)) continue;
+            fs::path relative = it->path().lexically_relative(root);
+            std::string name = relative.generic_string();
+            if (isHidden(relative) || endsWith(name, ".gz") || endsWith(name, ".br")) continue;
+
+            StaticFile file;
+            file.contentType = contentTypeFor(name);
+            if (!loadBody(it->path(), file.bodies[StaticFile::IDENTITY], "")) continue;
+
+            // Precompressed siblings, if current and worth it
+            static const struct {
+                StaticFile::Coding coding;
+                const char* extension;
+                const char* header;
+            } variants[] = {{StaticFile::GZIP, ".gz", "gzip"}, {StaticFile::BR, ".br", "br"}};
+            fs::file_time_type modified = fs::last_write_time(it->path(), fileError);
+            bool anyVariant = false;
+            for (const auto& v : variants) {
+                fs::path sibling = it->path();
+                sibling += v.extension;
+                if (!fs::is_regular_file(sibling, fileError) || fs::last_write_time(sibling, fileError) < modified) continue;
+                StaticBody& body = file.bodies[v.coding];
+                std::string suffix = std::string("-") + v.header;
+                if (!loadBody(sibling, body, suffix) || body.size >= file.bodies[StaticFile::IDENTITY].size) {
+#ifdef SQUID_HAVE_SENDFILE
+                    if (body.fd >= 0) ::close(body.fd);
+#endif
+                    body = StaticBody();
+                    continue;
+                }
+                body.headers = std::string("Content-Encoding: ") + v.header + "\r\n";
+                anyVariant = true;
+            }
+            for (StaticBody& body : file.bodies) {
+                if (!body.present()) continue;
+                body.headers += "ETag: " + body.etag + "\r\nCache-Control: no-cache\r\n";
+                if (anyVariant) body.headers += "Vary: Accept-Encoding\r\n";
+                memoryBytes += body.bytes.size();
+            }
+            files["/" + name] = std::move(file);
+        }
+        if (ec) {
+            error = root + ": " + ec.message();
+            return false;
+        }
+        return true;
+    }
+
+    // The file for a request path (no query string); "/" and paths ending in
+    // "/" mean the index.html there. Percent-escapes are decoded.
+    const StaticFile* find(std::string_view path) const {
+        if (path.empty()) return nullptr;
+        if (path.find('%') == std::string_view::npos && path.back() != '/') {
+            auto it = files.find(path);
+            return it == files.end() ? nullptr : &it->second;
+        }
+        thread_local std::string decoded; // keeps its capacity between requests
+        decoded.clear();
+        for (size_t i = 0; i < path.size(); i++) {
+            if (path[i] == '%' && i + 2 < path.size() && hexDigit(path[i + 1]) >= 0 && hexDigit(path[i + 2]) >= 0) {
+                decoded += (char)(hexDigit(path[i + 1]) * 16 + hexDigit(path[i + 2]));
+                i += 2;
+            } else {
+                decoded += path[i];
+            }
+        }
+        if (decoded.back() == '/') decoded += "index.html";
+        auto it = files.find(decoded);
+        return it == files.end() ? nullptr : &it->second;
+    }
+
+    // If-None-Match: "*" or a list of tags, weak (W/) ones compared by value
+    static bool etagMatches(std::string_view ifNoneMatch, std::string_view etag) {
+        while (!ifNoneMatch.empty()) {
+            size_t comma = ifNoneMatch.find(',');
+            std::string_view tag = ifNoneMatch.substr(0, comma);
+            ifNoneMatch = (comma == std::string_view::npos) ? std::string_view() : ifNoneMatch.substr(comma + 1);
+            while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t')) tag.remove_prefix(1);
+            while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t')) tag.remove_suffix(1);
+            if (tag == "*") return true;
+            if (tag.size() > 2 && tag[0] == 'W' && tag[1] == '/') tag.remove_prefix(2);
+            if (tag == etag) return true;
+        }
+        return false;
+    }
+};
@@ -0,0 +1,215 @@
+// Hierarchical timer wheel
+//
+// Four levels of 64 slots. Level 0 holds timers due within the next 64
+// ticks, level 1 those due within the next 64 blocks of 64 ticks, and so on,
+// so with the default 10 ms tick one wheel spans about 46 hours. Scheduling
+// and cancelling are O(1) (link or unlink a pool node); a timer moves down a
+// level at most three times before it fires. A per-level occupancy bitmap
+// lets advance() jump straight over idle stretches and tells the event loop
+// how long it may sleep.
+//
+// Single-threaded: each event loop owns its wheel. Timers further out than
+// the wheel spans fire early, at the far edge; owners that use long delays
+// re-check their deadline when the timer fires and re-arm for the rest.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+// Handle returned by schedule(); 0 is never a live timer
+using TimerId = uint64_t;
+
+template <typename Payload>
+class TimerWheel {
+private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        Payload payload;
+        uint64_t expires = 0;   // absolute tick
+        uint32_t prev = NIL;
+        uint32_t next = NIL;    // also links the free list
+        uint32_t generation = 1;
+        uint16_t slot = 0;      // level * SLOTS + index, for unlinking
+        bool live = false;
+    };
+
+    std::vector<Node> nodes;
+    uint32_t freeList = NIL;
+    uint32_t heads[LEVELS * SLOTS];
+    uint64_t occupied[LEVELS] = {};
+    uint64_t now = 0; // last processed tick
+    size_t count = 0;
+    std::chrono::steady_clock::time_point origin;
+    std::chrono::milliseconds tick;
+
+    static int lowestBit(uint64_t word) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return (int)index;
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+
+    static uint64_t rotateRight(uint64_t word, int by) {
+        return by ? (word >> by) | (word << (64 - by)) : word;
+    }
+
+    void link(uint32_t i) {
+        Node& n = nodes[i];
+        int level = 0;
+        while (level < LEVELS - 1 && (n.expires >> (SLOT_BITS * level)) - (now >> (SLOT_BITS * level)) >= SLOTS) level++;
+        int shift = SLOT_BITS * level;
+        if ((n.expires >> shift) - (now >> shift) >= SLOTS) {
+            n.expires = ((now >> shift) + SLOTS - 1) << shift; // beyond the wheel: fire at its far edge
+        }
+        int index = (int)((n.expires >> shift) & (SLOTS - 1));
+        n.slot = (uint16_t)(level * SLOTS + index);
+        n.prev = NIL;
+        n.next = heads[n.slot];
+        if (n.next != NIL) nodes[n.next].prev = i;
+        heads[n.slot] = i;
+        occupied[level] |= 1ull << index;
+    }
+
+    void unlink(uint32_t i) {
+        Node& n = nodes[i];
+        if (n.prev != NIL) {
+            nodes[n.prev].next = n.next;
+        } else {
+            heads[n.slot] = n.next;
+            if (n.next == NIL) occupied[n.slot / SLOTS] &= ~(1ull << (n.slot % SLOTS));
+        }
+        if (n.next != NIL) nodes[n.next].prev = n.prev;
+    }
+
+    void release(uint32_t i) {
+        Node& n = nodes[i];
+        n.live = false;
+        n.generation++;
+        n.next = freeList;
+        freeList = i;
+        count--;
+    }
+
+    // First tick after now at which a slot of this level fires or cascades
+    uint64_t nextEventAt(int level) const {
+        if (!occupied[level]) return UINT64_MAX;
+        int shift = SLOT_BITS * level;
+        uint64_t block = (now >> shift) + 1;
+        uint64_t ahead = (uint64_t)lowestBit(rotateRight(occupied[level], (int)(block & (SLOTS - 1))));
+        return (block + ahead) << shift;
+    }
+
+    uint64_t nextEventTick() const {
+        uint64_t next = UINT64_MAX;
+        for (int level = 0; level < LEVELS; level++) {
+            uint64_t at = nextEventAt(level);
+            if (at < next) next = at;
+        }
+        return next;
+    }
+
+    uint64_t ticksAt(std::chrono::steady_clock::time_point time) const {
+        if (time <= origin) return 0;
+        return (uint64_t)((time - origin) / tick);
+    }
+
+public:
+    explicit TimerWheel(std::chrono::milliseconds tickLength = std::chrono::milliseconds(10),
+                        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now())
+        : origin(start), tick(tickLength.count() > 0 ? tickLength : std::chrono::milliseconds(1)) {
+        for (uint32_t& head : heads) head = NIL;
+    }
+
+    size_t size() const { return count; }
+
+    // Run payload through fire() delayMs after the last advance(), rounded up
+    // to whole ticks
+    TimerId schedule(uint64_t delayMs, const Payload& payload) {
+        uint32_t i;
+        if (freeList != NIL) {
+            i = freeList;
+            freeList = nodes[i].next;
+        } else {
+            i = (uint32_t)nodes.size();
+            nodes.emplace_back();
+        }
+        Node& n = nodes[i];
+        uint64_t tickMs = (uint64_t)tick.count();
+        uint64_t ticks = (delayMs + tickMs - 1) / tickMs;
+        n.payload = payload;
+        n.expires = now + (ticks ? ticks : 1);
+        n.live = true;
+        link(i);
+        count++;
+        return ((uint64_t)n.generation << 32) | i;
+    }
+
+    // False if the timer already fired or was cancelled
+    bool cancel(TimerId id) {
+        uint32_t i = (uint32_t)id;
+        if (id == 0 || i >= nodes.size() || !nodes[i].live || nodes[i].generation != (uint32_t)(id >> 32)) return false;
+        unlink(i);
+        release(i);
+        return true;
+    }
+
+    // Fire every timer due by `time`, in tick order. fire(const Payload&) may
+    // schedule and cancel timers, including ones due in the same pass.
+    template <typename F>
+    void advance(std::chrono::steady_clock::time_point time, F&& fire) {
+        uint64_t target = ticksAt(time);
+        while (now < target) {
+            uint64_t next = nextEventTick();
+            if (next > target) {
+                now = target;
+                break;
+            }
+            now = next;
+            // Move the slots starting at this tick down a level, top level first
+            for (int level = LEVELS - 1; level > 0; level--) {
+                int shift = SLOT_BITS * level;
+                if (now & ((1ull << shift) - 1)) continue;
+                uint32_t& head = heads[level * SLOTS + ((now >> shift) & (SLOTS - 1))];
+                uint32_t i = head;
+                head = NIL;
+                occupied[level] &= ~(1ull << ((now >> shift) & (SLOTS - 1)));
+                while (i != NIL) {
+                    uint32_t following = nodes[i].next;
+                    link(i);
+                    i = following;
+                }
+            }
+            uint32_t& due = heads[now & (SLOTS - 1)];
+            while (due != NIL) {
+                uint32_t i = due;
+                unlink(i);
+                Payload payload = nodes[i].payload;
+                release(i);
+                fire(payload);
+            }
+        }
+    }
+
+    // Milliseconds until the next timer fires or cascades; -1 when idle.
+    // Suitable as an epoll_wait timeout.
+    long long msUntilNext(std::chrono::steady_clock::time_point time) const {
+        uint64_t next = nextEventTick();
+        if (next == UINT64_MAX) return -1;
+        auto due = origin + tick * (long long)next;
+        if (due <= time) return 0;
+        return (long long)std::chrono::ceil<std::chrono::milliseconds>(due - time).count();
+    }
+};
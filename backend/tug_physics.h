@@ -0,0 +1,363 @@
+// Tug of War physics
+//
+// One player's round is fully determined by a seed (the target window's
+// random walk) and the player's tap times, measured in seconds from the first
+// tap. TugPhysics steps one player tap by tap; replayTugBatch replays many
+// recorded timelines at once, 4 players per AVX2 instruction or 2 per SSE2
+// instruction, and returns exactly the strengths TugPhysics would. Exactly
+// means bit for bit: both paths perform the same IEEE double operations in the
+// same order, so do not build them with -ffast-math, and add
+// -ffp-contract=off when targeting FMA (e.g. -march=native).
+//
+// Lanes diverge only when the window's acceleration is re-rolled (timer
+// expiry or a bounce off the track edge). Each lane holds its next draw ready,
+// so a re-roll is a blend and only refilling the draw runs scalar code on
+// that lane's own generator.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rng.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SQUID_TUG_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SQUID_TUG_SSE2 1
+#endif
+
+// Track layout (abstract units)
+const double TUG_TRACK_W = 1000.0;
+const double TUG_TARGET_W = 100.0;
+const double TUG_TARGET_X0 = 18.0; // window start, px from left
+const double TUG_MIN_V = 80.0, TUG_MAX_V = 340.0, TUG_MAX_A = 600.0;
+const double TUG_ACCEL_MIN_SEC = 0.18, TUG_ACCEL_SPAN_SEC = 0.60; // re-roll acceleration after 0.18-0.78 s
+// Bar
+const double TUG_BAR_MIN = 6.0, TUG_BAR_MAX = TUG_TRACK_W * 0.85;
+const double TUG_SHRINK_SPEED = 210.0; // px/s
+const double TUG_BASE_INC = 30.0;      // px per tap
+const double TUG_MAX_DT = 0.2;         // step clamp for stability
+
+struct TugParams {
+    double durationSec = 10.0; // taps after this (counted from the first) are ignored
+    double gainPerSec = 28.0;  // strength per second while the bar tip is in the window
+};
+
+class TugPhysics {
+private:
+    Rng rng;
+    double targetX = TUG_TARGET_X0;
+    double targetV = 0.0; // px/s
+    double targetA = 0.0; // px/s^2
+    double accelTimer = 0.0;
+    double barW = TUG_BAR_MIN;
+    double tPrev = 0.0;
+    double lastTap = 0.0;
+    double total = 0.0;
+    bool started = false;
+    double gainPerSec;
+
+public:
+    static void randomizeAccel(Rng& rng, double& accel, double& timer) {
+        accel = (2.0 * rng.unit() - 1.0) * TUG_MAX_A;
+        timer = TUG_ACCEL_MIN_SEC + TUG_ACCEL_SPAN_SEC * rng.unit();
+    }
+
+    TugPhysics(uint64_t seed, const TugParams& params) : rng(seed), gainPerSec(params.gainPerSec) {
+        randomizeAccel(rng, targetA, accelTimer);
+    }
+
+    double tip() const { return barW; } // bar grows from left=0
+    double windowLeft() const { return targetX; }
+    double windowRight() const { return targetX + TUG_TARGET_W; }
+    double strength() const { return total; }
+
+    // Apply a tap at t seconds after the first tap; true if the tip landed in the window
+    bool tap(double t) {
+        if (!started) {
+            started = true;
+            tPrev = t;
+            lastTap = t;
+        }
+
+        // Time step since last interaction
+        double dt = t - tPrev;
+        if (dt > TUG_MAX_DT) dt = TUG_MAX_DT;
+        tPrev = t;
+
+        // Target random-walk update
+        accelTimer -= dt;
+        if (accelTimer <= 0.0) randomizeAccel(rng, targetA, accelTimer);
+        targetV += targetA * dt;
+        if (std::fabs(targetV) < TUG_MIN_V) targetV = (targetV >= 0.0 ? 1.0 : -1.0) * TUG_MIN_V;
+        if (targetV > TUG_MAX_V) targetV = TUG_MAX_V;
+        if (targetV < -TUG_MAX_V) targetV = -TUG_MAX_V;
+        targetX += targetV * dt;
+        if (targetX < 2.0) {
+            targetX = 2.0;
+            targetV = std::fabs(targetV);
+            randomizeAccel(rng, targetA, accelTimer);
+        }
+        if (targetX + TUG_TARGET_W > TUG_TRACK_W - 2.0) {
+            targetX = TUG_TRACK_W - 2.0 - TUG_TARGET_W;
+            targetV = -std::fabs(targetV);
+            randomizeAccel(rng, targetA, accelTimer);
+        }
+
+        // Passive shrink between taps
+        barW -= TUG_SHRINK_SPEED * dt;
+        if (barW < TUG_BAR_MIN) barW = TUG_BAR_MIN;
+
+        // Tap growth with frequency-based bonus
+        double dtTap = t - lastTap;
+        lastTap = t;
+        double bonus = std::min(5.0, 0.5 / std::max(0.04, dtTap));
+        double inc = TUG_BASE_INC * (1.0 + bonus);
+        barW = std::min(TUG_BAR_MAX, barW + inc);
+
+        // Score if bar tip inside target window
+        bool inWindow = (barW >= targetX && barW <= targetX + TUG_TARGET_W);
+        if (inWindow) total += dt * gainPerSec;
+        return inWindow;
+    }
+};
+
+// Reference replay of one timeline: taps are applied until one arrives after
+// a tap that was already past the round duration
+inline double replayTug(uint64_t seed, const double* taps, size_t count, const TugParams& params) {
+    TugPhysics player(seed, params);
+    for (size_t k = 0; k < count; k++) {
+        if (k > 0 && taps[k - 1] - taps[0] >= params.durationSec) break;
+        player.tap(taps[k] - taps[0]);
+    }
+    return player.strength();
+}
+
+#if defined(SQUID_TUG_AVX2) || defined(SQUID_TUG_SSE2)
+namespace tug_detail {
+
+#if defined(SQUID_TUG_AVX2)
+struct Lanes {
+    using V = __m256d;
+    static const int WIDTH = 4;
+    static V set1(double x) { return _mm256_set1_pd(x); }
+    static V load(const double* p) { return _mm256_loadu_pd(p); }
+    static V gather(const double* const* p) { return _mm256_set_pd(*p[3], *p[2], *p[1], *p[0]); }
+    static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm256_div_pd(a, b); }
+    static V min(V a, V b) { return _mm256_min_pd(a, b); }
+    static V max(V a, V b) { return _mm256_max_pd(a, b); }
+    static V lt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static V le(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static V gt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static V ge(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+    static V both(V a, V b) { return _mm256_and_pd(a, b); }
+    static V orv(V a, V b) { return _mm256_or_pd(a, b); }
+    static V select(V mask, V a, V b) { return _mm256_blendv_pd(b, a, mask); } // mask ? a : b
+    static V abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static V negAbs(V a) { return _mm256_or_pd(_mm256_set1_pd(-0.0), a); }
+    static int bits(V mask) { return _mm256_movemask_pd(mask); }
+};
+#else
+struct Lanes {
+    using V = __m128d;
+    static const int WIDTH = 2;
+    static V set1(double x) { return _mm_set1_pd(x); }
+    static V load(const double* p) { return _mm_loadu_pd(p); }
+    static V gather(const double* const* p) { return _mm_set_pd(*p[1], *p[0]); }
+    static void store(double* p, V v) { _mm_storeu_pd(p, v); }
+    static V add(V a, V b) { return _mm_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm_div_pd(a, b); }
+    static V min(V a, V b) { return _mm_min_pd(a, b); }
+    static V max(V a, V b) { return _mm_max_pd(a, b); }
+    static V lt(V a, V b) { return _mm_cmplt_pd(a, b); }
+    static V le(V a, V b) { return _mm_cmple_pd(a, b); }
+    static V gt(V a, V b) { return _mm_cmpgt_pd(a, b); }
+    static V ge(V a, V b) { return _mm_cmpge_pd(a, b); }
+    static V both(V a, V b) { return _mm_and_pd(a, b); }
+    static V orv(V a, V b) { return _mm_or_pd(a, b); }
+    static V select(V mask, V a, V b) { return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); }
+    static V abs(V a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static V negAbs(V a) { return _mm_or_pd(_mm_set1_pd(-0.0), a); }
+    static int bits(V mask) { return _mm_movemask_pd(mask); }
+};
+#endif
+
+// Streams players through Lanes::WIDTH lanes: a lane that finishes its
+// timeline immediately takes the next player, so lanes never wait on each
+// other. Each lane keeps its next acceleration draw ready in pendA/pendT; a
+// re-roll is then a blend, and the replacement draw is made off the critical
+// path. Per lane the draws come in the same order as in TugPhysics.
+inline void replayStream(const uint64_t* seeds, const double* taps, const size_t* offsets, size_t players,
+                         const TugParams& params, double* strengthOut) {
+    using L = Lanes;
+    using V = L::V;
+    const int W = L::WIDTH;
+    enum { X, VEL, ACCEL, TIMER, BAR, PREV, LAST, TOTAL, FIELDS };
+
+    std::vector<Rng> rngs(W, Rng(0));
+    static const double idle = 0.0;
+    size_t player[W];
+    const double* next[W];
+    size_t remaining[W];
+    alignas(32) double origin[W], pendA[W], pendT[W], spill[FIELDS][W];
+    size_t nextPlayer = 0;
+    int live = 0;
+
+    // Write out the players in these lanes and start the next ones
+    auto retire = [&](int lanes) {
+        for (int i = 0; i < W; i++) {
+            if (!(lanes >> i & 1)) continue;
+            if (live >> i & 1) strengthOut[player[i]] = spill[TOTAL][i];
+            live &= ~(1 << i);
+            next[i] = &idle;
+            origin[i] = 0.0;
+            while (nextPlayer < players) {
+                size_t p = nextPlayer++;
+                const double* first = taps + offsets[p];
+                const double* last = taps + offsets[p + 1];
+                if (first == last) {
+                    strengthOut[p] = 0.0; // never tapped
+                    continue;
+                }
+                // Same cut as replayTug: up to and including the first tap past the duration
+                const double* late = std::partition_point(
+                    first, last, [&](double t) { return !(t - *first >= params.durationSec); });
+                player[i] = p;
+                next[i] = first;
+                remaining[i] = (size_t)(late == last ? last - first : late - first + 1);
+                origin[i] = *first;
+                rngs[i].reseed(seeds[p]);
+                spill[X][i] = TUG_TARGET_X0;
+                spill[VEL][i] = 0.0;
+                TugPhysics::randomizeAccel(rngs[i], spill[ACCEL][i], spill[TIMER][i]);
+                TugPhysics::randomizeAccel(rngs[i], pendA[i], pendT[i]);
+                spill[BAR][i] = TUG_BAR_MIN;
+                spill[PREV][i] = 0.0; // first tap is at 0, so dt = 0
+                spill[LAST][i] = 0.0;
+                spill[TOTAL][i] = 0.0;
+                live |= 1 << i;
+                break;
+            }
+        }
+    };
+
+    for (int f = 0; f < FIELDS; f++) {
+        for (int i = 0; i < W; i++) spill[f][i] = 0.0;
+    }
+    retire((1 << W) - 1);
+    V targetX = L::load(spill[X]), targetV = L::load(spill[VEL]), targetA = L::load(spill[ACCEL]);
+    V accelTimer = L::load(spill[TIMER]), barW = L::load(spill[BAR]), tPrev = L::load(spill[PREV]);
+    V lastTap = L::load(spill[LAST]), total = L::load(spill[TOTAL]), start = L::load(origin);
+
+    // Lanes in `mask` take their pending draw; `lanes` (live ones only) draw again
+    auto reroll = [&](V mask, int lanes, V& accel, V& timer) {
+        accel = L::select(mask, L::load(pendA), accel);
+        timer = L::select(mask, L::load(pendT), timer);
+        for (int i = 0; i < W; i++) {
+            if (lanes >> i & 1) TugPhysics::randomizeAccel(rngs[i], pendA[i], pendT[i]);
+        }
+    };
+
+    const V maxDt = L::set1(TUG_MAX_DT), zero = L::set1(0.0), minV = L::set1(TUG_MIN_V);
+    const V negMinV = L::set1(-1.0 * TUG_MIN_V), maxV = L::set1(TUG_MAX_V), negMaxV = L::set1(-TUG_MAX_V);
+    const V edgeLow = L::set1(2.0), edgeHigh = L::set1(TUG_TRACK_W - 2.0);
+    const V parkHigh = L::set1(TUG_TRACK_W - 2.0 - TUG_TARGET_W), targetW = L::set1(TUG_TARGET_W);
+    const V shrink = L::set1(TUG_SHRINK_SPEED), barMin = L::set1(TUG_BAR_MIN), barMax = L::set1(TUG_BAR_MAX);
+    const V maxBonus = L::set1(5.0), half = L::set1(0.5), minTapGap = L::set1(0.04);
+    const V one = L::set1(1.0), baseInc = L::set1(TUG_BASE_INC), gain = L::set1(params.gainPerSec);
+
+    while (live) {
+        // Read straight from the timelines; idle lanes (no players left) read a
+        // dummy time and their results are discarded
+        V t = L::sub(L::gather(next), start);
+        int finished = 0;
+        for (int i = 0; i < W; i++) {
+            if (!(live >> i & 1)) continue;
+            next[i]++;
+            finished |= (int)(--remaining[i] == 0) << i;
+        }
+
+        V dt = L::min(L::sub(t, tPrev), maxDt);
+        tPrev = t;
+
+        accelTimer = L::sub(accelTimer, dt);
+        V expired = L::le(accelTimer, zero);
+        if (int lanes = L::bits(expired) & live) reroll(expired, lanes, targetA, accelTimer);
+
+        V v = L::add(targetV, L::mul(targetA, dt));
+        v = L::select(L::lt(L::abs(v), minV), L::select(L::ge(v, zero), minV, negMinV), v);
+        v = L::min(v, maxV);
+        v = L::max(v, negMaxV);
+        V x = L::add(targetX, L::mul(v, dt));
+
+        V low = L::lt(x, edgeLow);
+        x = L::select(low, edgeLow, x);
+        v = L::select(low, L::abs(v), v);
+        if (int lanes = L::bits(low) & live) reroll(low, lanes, targetA, accelTimer);
+        V high = L::gt(L::add(x, targetW), edgeHigh);
+        x = L::select(high, parkHigh, x);
+        v = L::select(high, L::negAbs(v), v);
+        if (int lanes = L::bits(high) & live) reroll(high, lanes, targetA, accelTimer);
+        targetX = x;
+        targetV = v;
+
+        V bar = L::max(L::sub(barW, L::mul(shrink, dt)), barMin);
+        V dtTap = L::sub(t, lastTap);
+        lastTap = t;
+        V bonus = L::min(maxBonus, L::div(half, L::max(minTapGap, dtTap)));
+        V inc = L::mul(baseInc, L::add(one, bonus));
+        barW = L::min(barMax, L::add(bar, inc));
+
+        V inWindow = L::both(L::ge(barW, x), L::le(barW, L::add(x, targetW)));
+        total = L::select(inWindow, L::add(total, L::mul(dt, gain)), total);
+
+        if (finished) {
+            L::store(spill[X], targetX);
+            L::store(spill[VEL], targetV);
+            L::store(spill[ACCEL], targetA);
+            L::store(spill[TIMER], accelTimer);
+            L::store(spill[BAR], barW);
+            L::store(spill[PREV], tPrev);
+            L::store(spill[LAST], lastTap);
+            L::store(spill[TOTAL], total);
+            retire(finished);
+            targetX = L::load(spill[X]);
+            targetV = L::load(spill[VEL]);
+            targetA = L::load(spill[ACCEL]);
+            accelTimer = L::load(spill[TIMER]);
+            barW = L::load(spill[BAR]);
+            tPrev = L::load(spill[PREV]);
+            lastTap = L::load(spill[LAST]);
+            total = L::load(spill[TOTAL]);
+            start = L::load(origin);
+        }
+    }
+}
+
+} // namespace tug_detail
+#endif
+
+// Replay many timelines. Lane i uses seeds[i] and the taps
+// taps[offsets[i]] .. taps[offsets[i + 1] - 1] (non-decreasing seconds; any
+// origin), and strengthOut[i] receives replayTug's result for that lane.
+inline void replayTugBatch(const uint64_t* seeds, const double* taps, const size_t* offsets, size_t lanes,
+                           const TugParams& params, double* strengthOut) {
+#if defined(SQUID_TUG_AVX2) || defined(SQUID_TUG_SSE2)
+    tug_detail::replayStream(seeds, taps, offsets, lanes, params, strengthOut);
+#else
+    for (size_t lane = 0; lane < lanes; lane++) {
+        strengthOut[lane] = replayTug(seeds[lane], taps + offsets[lane], offsets[lane + 1] - offsets[lane], params);
+    }
+#endif
+}
@@ -0,0 +1,354 @@
+// Minimal io_uring for the event loop
+//
+// The kernel interface is used directly: io_uring_setup, io_uring_enter and
+// io_uring_register plus the shared rings they map, as described in
+// <linux/io_uring.h>. That avoids a liburing dependency. It covers only what
+// the server needs:
+// - a submission queue whose entries go to the kernel together with the wait
+//   for completions, in one io_uring_enter per loop iteration;
+// - a completion queue read straight from shared memory;
+// - one ring of provided receive buffers, registered with the kernel, that
+//   multishot recv picks from.
+//
+// Uring::probe() decides at startup whether this kernel can run the io_uring
+// loop. That needs Linux 6.0 or later, for multishot recv, provided buffer
+// rings and cancel-by-fd. Each worker then opens its own ring on its own
+// thread, so the ring can be created single-issuer with deferred task work.
+#pragma once
+
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #define SQUID_HAVE_URING 1
+    #endif
+#endif
+
+#ifdef SQUID_HAVE_URING
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+class Uring {
+public:
+    static const uint16_t BUFFER_GROUP = 0;
+
+private:
+    int ringFd = -1;
+    void* ringMap = nullptr; // SQ and CQ rings share one mapping (IORING_FEAT_SINGLE_MMAP)
+    size_t ringBytes = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqeBytes = 0;
+
+    std::atomic<unsigned>* sqHead = nullptr;
+    std::atomic<unsigned>* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned sqLocalTail = 0; // entries up to here are filled in; the kernel consumes from sqHead
+
+    std::atomic<unsigned>* cqHead = nullptr;
+    std::atomic<unsigned>* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    // Provided receive buffers: one ring of `bufferCount` entries, each
+    // pointing at a `bufferSize` slice of bufferMemory
+    io_uring_buf_ring* bufRing = nullptr;
+    size_t bufRingBytes = 0;
+    char* bufferMemory = nullptr;
+    unsigned bufferCount = 0;
+    unsigned bufferSize = 0;
+
+    static int setup(unsigned entries, io_uring_params& p) { return (int)syscall(__NR_io_uring_setup, entries, &p); }
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize) {
+        return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, arg, argSize);
+    }
+    int registerOp(unsigned opcode, void* arg, unsigned count) {
+        return (int)syscall(__NR_io_uring_register, ringFd, opcode, arg, count);
+    }
+
+    // Make the filled-in entries visible to the kernel; returns how many it has not consumed yet
+    unsigned publish() {
+        sqTail->store(sqLocalTail, std::memory_order_release);
+        return sqLocalTail - sqHead->load(std::memory_order_acquire);
+    }
+
+public:
+    Uring() = default;
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+    ~Uring() { close(); }
+
+    bool isOpen() const { return ringFd >= 0; }
+
+    // Whether this kernel runs the io_uring loop; error says why not
+    static bool probe(std::string& error) {
+        utsname name;
+        int major = 0, minor = 0;
+        if (uname(&name) != 0 || sscanf(name.release, "%d.%d", &major, &minor) != 2 || major < 6) {
+            error = "needs Linux 6.0 or later";
+            return false;
+        }
+        Uring ring;
+        if (!ring.open(8, false, error)) return false;
+        if (!ring.setupBuffers(8, 4096, error)) return false;
+        return true;
+    }
+
+    // singleIssuer: only the calling thread will ever submit, which lets the
+    // kernel run completions when that thread waits instead of interrupting it
+    bool open(unsigned entries, bool singleIssuer, std::string& error) {
+        io_uring_params p = {};
+        p.flags = IORING_SETUP_SUBMIT_ALL | (singleIssuer ? IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN : 0);
+        p.flags |= IORING_SETUP_CQSIZE;
+        p.cq_entries = entries * 4; // multishot operations post many completions per submission
+        ringFd = setup(entries, p);
+        if (ringFd < 0 && singleIssuer) {
+            p = {};
+            p.flags = IORING_SETUP_CQSIZE;
+            p.cq_entries = entries * 4;
+            ringFd = setup(entries, p);
+        }
+        if (ringFd < 0) {
+            error = std::string("io_uring_setup: ") + strerror(errno);
+            return false;
+        }
+        const unsigned needed = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+        if ((p.features & needed) != needed) {
+            error = "io_uring lacks single mmap, nodrop or extended wait arguments";
+            close();
+            return false;
+        }
+
+        size_t sqBytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        size_t cqBytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        ringBytes = sqBytes > cqBytes ? sqBytes : cqBytes;
+        ringMap = mmap(nullptr, ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        sqeBytes = p.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMap = mmap(nullptr, sqeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (ringMap == MAP_FAILED || sqeMap == MAP_FAILED) {
+            if (ringMap == MAP_FAILED) ringMap = nullptr;
+            if (sqeMap != MAP_FAILED) munmap(sqeMap, sqeBytes);
+            error = std::string("io_uring mmap: ") + strerror(errno);
+            close();
+            return false;
+        }
+        sqes = (io_uring_sqe*)sqeMap;
+
+        char* base = (char*)ringMap;
+        sqHead = (std::atomic<unsigned>*)(base + p.sq_off.head);
+        sqTail = (std::atomic<unsigned>*)(base + p.sq_off.tail);
+        sqMask = *(unsigned*)(base + p.sq_off.ring_mask);
+        sqEntries = p.sq_entries;
+        sqLocalTail = sqTail->load(std::memory_order_relaxed);
+        unsigned* array = (unsigned*)(base + p.sq_off.array);
+        for (unsigned i = 0; i < sqEntries; i++) array[i] = i; // slot i always holds sqes[i]
+
+        cqHead = (std::atomic<unsigned>*)(base + p.cq_off.head);
+        cqTail = (std::atomic<unsigned>*)(base + p.cq_off.tail);
+        cqMask = *(unsigned*)(base + p.cq_off.ring_mask);
+        cqes = (io_uring_cqe*)(base + p.cq_off.cqes);
+        return true;
+    }
+
+    // Register `count` (a power of two) receive buffers of `size` bytes
+    bool setupBuffers(unsigned count, unsigned size, std::string& error) {
+        bufRingBytes = count * sizeof(io_uring_buf);
+        void* ringMem = mmap(nullptr, bufRingBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        void* memory = mmap(nullptr, (size_t)count * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ringMem == MAP_FAILED || memory == MAP_FAILED) {
+            if (ringMem != MAP_FAILED) munmap(ringMem, bufRingBytes);
+            if (memory != MAP_FAILED) munmap(memory, (size_t)count * size);
+            error = std::string("receive buffers: ") + strerror(errno);
+            return false;
+        }
+        bufRing = (io_uring_buf_ring*)ringMem;
+        bufferMemory = (char*)memory;
+        bufferCount = count;
+        bufferSize = size;
+
+        io_uring_buf_reg reg = {};
+        reg.ring_addr = (uint64_t)(uintptr_t)bufRing;
+        reg.ring_entries = count;
+        reg.bgid = BUFFER_GROUP;
+        if (registerOp(IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+            error = std::string("io_uring buffer ring: ") + strerror(errno);
+            return false;
+        }
+        bufRing->tail = 0;
+        for (unsigned id = 0; id < count; id++) recycleBuffer((uint16_t)id);
+        return true;
+    }
+
+    char* buffer(uint16_t id) const { return bufferMemory + (size_t)id * bufferSize; }
+    unsigned bufferBytes() const { return bufferSize; }
+
+    // Give a receive buffer back to the kernel
+    void recycleBuffer(uint16_t id) {
+        unsigned short tail = bufRing->tail;
+        // Not bufRing->bufs: the header declares it as a flexible array that
+        // C++ places after an empty struct, 8 bytes off
+        io_uring_buf& slot = ((io_uring_buf*)bufRing)[tail & (bufferCount - 1)];
+        slot.addr = (uint64_t)(uintptr_t)buffer(id);
+        slot.len = bufferSize;
+        slot.bid = id;
+        __atomic_store_n(&bufRing->tail, (unsigned short)(tail + 1), __ATOMIC_RELEASE);
+    }
+
+    // Room for `count` more entries, submitting what is queued if needed.
+    // Linked entries must be taken after one reserve(), so that none of them
+    // is handed to the kernel before the others are filled in.
+    bool reserve(unsigned count) {
+        if (sqLocalTail - sqHead->load(std::memory_order_acquire) + count <= sqEntries) return true;
+        submit();
+        return sqLocalTail - sqHead->load(std::memory_order_acquire) + count <= sqEntries;
+    }
+
+    // A zeroed submission entry, or nullptr if the queue is full even after
+    // handing what it holds to the kernel
+    io_uring_sqe* nextSqe() {
+        if (!reserve(1)) return nullptr;
+        io_uring_sqe* sqe = &sqes[sqLocalTail & sqMask];
+        memset(sqe, 0, sizeof(*sqe));
+        sqLocalTail++;
+        return sqe;
+    }
+
+    // Hand queued entries to the kernel without waiting
+    int submit() {
+        unsigned pending = publish();
+        return pending ? enter(pending, 0, 0, nullptr, 0) : 0;
+    }
+
+    // Submit everything queued and wait up to timeoutMs (< 0: no limit) for
+    // at least one completion, in a single system call
+    int submitAndWait(long long timeoutMs) {
+        unsigned pending = publish();
+        unsigned waitFor = cqHead->load(std::memory_order_relaxed) != cqTail->load(std::memory_order_acquire) ? 0 : 1;
+        __kernel_timespec ts = {};
+        io_uring_getevents_arg arg = {};
+        if (timeoutMs >= 0) {
+            ts.tv_sec = timeoutMs / 1000;
+            ts.tv_nsec = (timeoutMs % 1000) * 1000000;
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+        }
+        return enter(pending, waitFor, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    }
+
+    // fn(const io_uring_cqe&) for every completion posted so far
+    template <typename F>
+    unsigned drain(F&& fn) {
+        unsigned head = cqHead->load(std::memory_order_relaxed);
+        unsigned tail = cqTail->load(std::memory_order_acquire);
+        unsigned count = tail - head;
+        for (; head != tail; head++) {
+            io_uring_cqe cqe = cqes[head & cqMask];
+            cqHead->store(head + 1, std::memory_order_release); // the slot may be reused from here
+            fn(cqe);
+        }
+        return count;
+    }
+
+    void close() {
+        if (ringMap) munmap(ringMap, ringBytes);
+        if (sqes) munmap(sqes, sqeBytes);
+        if (bufRing) munmap(bufRing, bufRingBytes);
+        if (bufferMemory) munmap(bufferMemory, (size_t)bufferCount * bufferSize);
+        if (ringFd >= 0) ::close(ringFd);
+        ringMap = nullptr;
+        sqes = nullptr;
+        bufRing = nullptr;
+        bufferMemory = nullptr;
+        ringFd = -1;
+    }
+
+    // ---- Submission helpers; user data comes back in the completion ----
+
+    static void prepMultishotAccept(io_uring_sqe* sqe, int listenFd, uint64_t userData) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listenFd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        sqe->user_data = userData;
+    }
+
+    // Receive into a provided buffer until cancelled or the peer closes
+    static void prepMultishotRecv(io_uring_sqe* sqe, int fd, uint64_t userData) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        sqe->user_data = userData;
+    }
+
+    static void prepSend(io_uring_sqe* sqe, int fd, const void* data, size_t len, uint64_t userData) {
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)(uintptr_t)data;
+        sqe->len = (unsigned)len;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = userData;
+    }
+
+    static void prepSendmsg(io_uring_sqe* sqe, int fd, const msghdr* msg, uint64_t userData) {
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)(uintptr_t)msg;
+        sqe->len = 1;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = userData;
+    }
+
+    // One-shot readiness wait, for writes that are not ring operations (sendfile)
+    static void prepPollOut(io_uring_sqe* sqe, int fd, uint64_t userData) {
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->poll32_events = POLLOUT;
+        sqe->user_data = userData;
+    }
+
+    static void prepRead(io_uring_sqe* sqe, int fd, void* data, size_t len, uint64_t userData) {
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)(uintptr_t)data;
+        sqe->len = (unsigned)len;
+        sqe->off = (uint64_t)-1; // current position; eventfds have none
+        sqe->user_data = userData;
+    }
+
+    // Cancel the operation submitted with targetUserData
+    static void prepCancel(io_uring_sqe* sqe, uint64_t targetUserData, uint64_t userData) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = targetUserData;
+        sqe->user_data = userData;
+    }
+
+    // Cancel every operation in flight on fd
+    static void prepCancelAll(io_uring_sqe* sqe, int fd, uint64_t userData) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = fd;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = userData;
+    }
+
+    static void prepClose(io_uring_sqe* sqe, int fd, uint64_t userData) {
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = fd;
+        sqe->user_data = userData;
+    }
+};
+
+#endif
@@ -0,0 +1,107 @@
+// Work-stealing parallel loop
+//
+// parallelFor(count, threads, fn) calls fn(worker, i) once for every i in
+// [0, count). Each worker starts with an equal slice of the range and takes
+// small chunks from the front of its own slice, touching only its own lock.
+// A worker that runs dry steals the back half of the largest slice still
+// left, so uneven items or a descheduled core do not leave threads idle at
+// the end. Slices only ever shrink, so once a steal pass finds every slice
+// empty the whole range has been handed out.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingRange {
+private:
+    struct alignas(64) Slice {
+        std::mutex lock;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    std::unique_ptr<Slice[]> slices;
+    unsigned workers;
+    size_t chunk;
+
+    // Move the back half of the fullest other slice into ours
+    bool steal(unsigned thief) {
+        while (true) {
+            unsigned victim = thief;
+            size_t most = 0;
+            for (unsigned w = 0; w < workers; w++) {
+                if (w == thief) continue;
+                std::lock_guard<std::mutex> guard(slices[w].lock);
+                size_t left = slices[w].end - slices[w].begin;
+                if (left > most) {
+                    most = left;
+                    victim = w;
+                }
+            }
+            if (victim == thief) return false;
+
+            size_t begin, end;
+            {
+                std::lock_guard<std::mutex> guard(slices[victim].lock);
+                Slice& v = slices[victim];
+                if (v.begin == v.end) continue; // emptied meanwhile; look again
+                begin = v.begin + (v.end - v.begin) / 2;
+                end = v.end;
+                v.end = begin;
+            }
+            std::lock_guard<std::mutex> guard(slices[thief].lock);
+            slices[thief].begin = begin;
+            slices[thief].end = end;
+            return true;
+        }
+    }
+
+public:
+    WorkStealingRange(size_t count, unsigned workerCount, size_t chunkSize)
+        : slices(new Slice[workerCount]), workers(workerCount), chunk(std::max<size_t>(1, chunkSize)) {
+        for (unsigned w = 0; w < workers; w++) {
+            slices[w].begin = count * w / workers;
+            slices[w].end = count * (w + 1) / workers;
+        }
+    }
+
+    // Next chunk [begin, end) for this worker; false when all work is taken
+    bool next(unsigned worker, size_t& begin, size_t& end) {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> guard(slices[worker].lock);
+                Slice& s = slices[worker];
+                if (s.begin < s.end) {
+                    begin = s.begin;
+                    end = std::min(s.end, s.begin + chunk);
+                    s.begin = end;
+                    return true;
+                }
+            }
+            if (!steal(worker)) return false;
+        }
+    }
+};
+
+// fn(unsigned worker, size_t index); worker is in [0, threads) and lets the
+// caller keep per-thread state. The calling thread runs worker 0.
+template <typename F>
+void parallelFor(size_t count, unsigned threads, F&& fn, size_t chunk = 64) {
+    threads = std::max(1u, threads);
+    WorkStealingRange range(count, threads, chunk);
+    auto work = [&](unsigned worker) {
+        size_t begin, end;
+        while (range.next(worker, begin, end)) {
+            for (size_t i = begin; i < end; i++) fn(worker, i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned w = 1; w < threads; w++) pool.emplace_back(work, w);
+    work(0);
+    for (auto& t : pool) t.join();
+}
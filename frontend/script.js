@@ -5,7 +5,12 @@ class GameState {
     this.currentPlayerIndex = 0;
     this.currentGameIndex = 0;
     this.gameNames = ["Red Light Green Light", "Glass Bridge", "Tug of War"];
-    this.apiUrl = "http://localhost:8080"; // Backend API URL
+    // Backend API URL: the page's own origin when the backend serves it,
+    // otherwise the backend's default port
+    this.apiUrl =
+      location.protocol.startsWith("http") && location.port !== "3000"
+        ? location.origin
+        : "http://localhost:8080";
     this.devMode = false; // Dev buttons hidden by default
     // Glass Bridge guarantee: one player guaranteed to succeed when >=3 alive
     this.glassBridgeGuaranteedName = null;
@@ -171,6 +176,27 @@ async function callBackend(endpoint, data) {
   }
 }
 
+// Room events pushed by the backend (Server-Sent Events): the doll's light as
+// it changes, plus eliminations and broken panels. EventSource reconnects on
+// its own; without a backend the game just keeps its local light.
+function subscribeRoomEvents(room = "") {
+  if (typeof EventSource === "undefined") return null;
+  const events = new EventSource(
+    `${gameState.apiUrl}/events?room=${encodeURIComponent(room)}`
+  );
+  events.addEventListener("light", (event) => {
+    const light = JSON.parse(event.data).light;
+    const lightIndicator = document.getElementById("lightIndicator");
+    const lightText = document.getElementById("lightText");
+    if (!lightIndicator || !lightText || light === "OFF") return;
+    lightIndicator.className = `light-circle ${light.toLowerCase()}`;
+    lightText.className = `light-text ${light.toLowerCase()}`;
+    lightText.textContent = light;
+  });
+  events.addEventListener("eliminated", () => updatePlayerStats());
+  return events;
+}
+
 // ================= Local Backend Simulation (Fallback) =================
 function simulateBackend(endpoint, data) {
   // Simulate C++ backend logic in JavaScript
@@ -1640,6 +1666,9 @@ document.addEventListener("DOMContentLoaded", () => {
 
   // Initialize stats display
   updatePlayerStats();
+
+  // Light changes arrive as they happen instead of with the next action
+  subscribeRoomEvents();
 });
 
 function updatePlayerStats() {
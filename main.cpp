@@ -1,13 +1,28 @@
 // Squid Game - Game Controller (backend orchestration)
+//
+// Interactive by default. With --simulate=N the same games run headless:
+// every player is a bot driven by a Strategy, and N tournaments are spread
+// over all cores to collect survival statistics for difficulty tuning.
 #include <algorithm>
 #include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <random>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
+
+#include "backend/player_columns.h"
+#include "backend/results_log.h"
+#include "backend/rng.h"
+#include "backend/tug_physics.h"
+#include "backend/work_stealing.h"
 using namespace std;
 
 // Util
@@ -18,14 +33,50 @@ static string toLower(string s)
 }
 static void sleepMs(int ms) { this_thread::sleep_for(chrono::milliseconds(ms)); }
 
-// Core model
-struct Player
+// Difficulty knobs; the simulator can override them from the command line
+struct GameTuning
 {
-    string name;
-    bool alive = true;
-    int rlgAttempts = 0;      // RLGL
-    int bridgeStep = 0;       // Glass Bridge
-    double tugStrength = 0.0; // Tug of War
+    int rlglRequired = 4;           // successful GREEN moves
+    double rlglTimeLimitSec = 20.0; // round budget
+    int bridgeSteps = 5;
+    double bridgeSafeChance = 0.60; // chosen tile safe (after step 1, unless guaranteed)
+    double tugDurationSec = 10.0;   // starts on the first tap
+    double tugGainPerSec = 28.0;    // strength gained per second while aligned
+};
+static GameTuning tuning;
+
+// Decisions for one player. The console controller prompts on stdin and reads
+// the wall clock; bots decide from a Strategy and advance their own simulated
+// clock, so a whole tournament runs without blocking or sleeping.
+class PlayerController
+{
+public:
+    virtual ~PlayerController();
+    virtual bool verbose() const { return false; }            // narrate on stdout
+    virtual double now() = 0;                                  // game clock, seconds
+    virtual bool moveOnLight(bool isGreen) = 0;                // RLGL: move on this light?
+    virtual bool chooseLeft(int step, int totalSteps) = 0;     // Glass Bridge
+    virtual void beginTaps() {}                                // Tug of War is about to start
+    virtual bool tap(double tip, double windowL, double windowR) = 0; // next tap; false = stop
+};
+
+// Core model: one row per player, stored column-wise so passes over millions
+// of simulated players touch only the fields they use
+struct PlayerTable
+{
+    NamePool names;                       // interned; survives clear()
+    vector<uint32_t> nameId;
+    vector<PlayerController *> controller;
+    BitColumn alive;
+    vector<int> rlgAttempts;    // RLGL
+    vector<int> bridgeStep;     // Glass Bridge
+    vector<double> tugStrength; // Tug of War
+    vector<int> gamesCleared;   // games finished alive
+
+    size_t size() const { return nameId.size(); }
+    string_view name(size_t i) const { return names.view(nameId[i]); }
+    void add(string_view playerName, PlayerController *c);
+    void clear();
 };
 
 class Game
@@ -33,23 +84,19 @@ class Game
 public:
     virtual ~Game();
     virtual const char *title() const = 0;
-    virtual void startRound(vector<Player> &players);
-    virtual void play(Player &p) = 0;
+    virtual void startRound(PlayerTable &players);
+    virtual void play(PlayerTable &players, size_t i) = 0;
 };
 
-// RNG
-static mt19937 &rng()
-{
-    static mt19937 eng((unsigned)chrono::high_resolution_clock::now().time_since_epoch().count());
-    return eng;
-}
+// RNG (same per-thread generator as the HTTP backend; --seed=N replays a run)
+static Rng &rng() { return threadRng(); }
 
 // Red Light, Green Light
 class RedLightGreenLight : public Game
 {
 public:
     const char *title() const override;
-    void play(Player &p) override;
+    void play(PlayerTable &players, size_t i) override;
 };
 
 // Glass Bridge
@@ -57,11 +104,11 @@ class GlassBridge : public Game
 {
 public:
     const char *title() const override;
-    void startRound(vector<Player> &players) override;
-    void play(Player &p) override;
+    void startRound(PlayerTable &players) override;
+    void play(PlayerTable &players, size_t i) override;
 
 private:
-    string guaranteedName;
+    size_t guaranteed = SIZE_MAX; // row of the guaranteed survivor, if any
 };
 
 // Tug of War
@@ -72,129 +119,433 @@ class TugOfWar : public Game
 {
 public:
     const char *title() const override;
-    void play(Player &p) override;
+    void play(PlayerTable &players, size_t i) override;
 };
 
 class GameManager
 {
 public:
-    void addPlayer(const string &name);
+    void addPlayer(string_view name, PlayerController *controller);
+    void clearPlayers() { players.clear(); }
     void addGame(Game *g);
+    void setVerbose(bool v) { verbose = v; }
     void run();
+    const PlayerTable &roster() const { return players; }
 
 private:
     void showRulesOnce(int gameIndex);
     void applyTugSurvivors();
     void printResults();
 
-    vector<Player> players;
+public:
+    bool saveResults(const string &path);
+
+private:
+
+    PlayerTable players;
     vector<Game *> games;
     map<int, bool> rulesShown;
+    bool verbose = true;
+};
+
+// Interactive player on stdin/stdout
+class ConsoleController : public PlayerController
+{
+public:
+    bool verbose() const override { return true; }
+    double now() override;
+    bool moveOnLight(bool isGreen) override;
+    bool chooseLeft(int step, int totalSteps) override;
+    void beginTaps() override;
+    bool tap(double tip, double windowL, double windowR) override;
+};
+
+// How a bot plays; one per named strategy in the simulator
+enum BridgePolicy
+{
+    BRIDGE_RANDOM,
+    BRIDGE_LEFT,
+    BRIDGE_ALTERNATE
+};
+
+struct Strategy
+{
+    const char *name;
+    double reactionSec;  // mean time to respond to a light (0.5x - 1.5x)
+    double mistakeRate;  // chance of doing the wrong thing on a light
+    BridgePolicy bridge;
+    double tapHz;        // taps per second
+    double tapJitter;    // +- fraction of the tap interval
+    bool tracking;       // wait for the bar to shrink when the tip is high in the window
+};
+
+static const Strategy STRATEGIES[] = {
+    {"careful", 0.8, 0.02, BRIDGE_RANDOM, 5.0, 0.2, false},
+    {"reckless", 0.3, 0.10, BRIDGE_LEFT, 12.0, 0.3, false},
+    {"slow", 2.5, 0.01, BRIDGE_ALTERNATE, 3.0, 0.2, false},
+    {"tracker", 0.6, 0.04, BRIDGE_RANDOM, 8.0, 0.2, true},
+};
+static const int STRATEGY_COUNT = (int)(sizeof(STRATEGIES) / sizeof(STRATEGIES[0]));
+
+class BotController : public PlayerController
+{
+public:
+    explicit BotController(const Strategy &s) : strategy(&s) {}
+    double now() override { return clock; }
+    bool moveOnLight(bool isGreen) override;
+    bool chooseLeft(int step, int totalSteps) override;
+    bool tap(double tip, double windowL, double windowR) override;
+
+private:
+    const Strategy *strategy;
+    double clock = 0.0;
+};
+
+// Console session journal (--journal=PATH): a header with the seed, tuning and
+// player names, then one 16-byte Decision per controller call. The games draw
+// only from the seeded generator, so feeding the decisions back (--replay=PATH)
+// plays the session out exactly as it happened, without prompting.
+enum DecisionKind : uint8_t
+{
+    DECISION_NOW,
+    DECISION_MOVE,
+    DECISION_CHOOSE_LEFT,
+    DECISION_BEGIN_TAPS,
+    DECISION_TAP
+};
+
+struct Decision
+{
+    uint8_t kind = DECISION_NOW;
+    uint8_t reserved[7] = {};
+    double value = 0.0; // the clock reading, or 1/0 for a yes/no decision
+};
+static_assert(sizeof(Decision) == 16, "decisions are fixed 16-byte records");
+
+struct SessionHeader
+{
+    char magic[8] = {'S', 'Q', 'C', 'O', 'N', 'S', '1', 0};
+    uint64_t seed = 0;
+    GameTuning tuning;
+    uint32_t players = 0; // followed by each name: uint32 length, then the bytes
+};
+
+// Passes every call to another controller and journals the answer
+class RecordingController : public PlayerController
+{
+public:
+    RecordingController(PlayerController &inner, FILE *out) : inner(&inner), out(out) {}
+    bool verbose() const override { return inner->verbose(); }
+    double now() override { return record(DECISION_NOW, inner->now()); }
+    bool moveOnLight(bool isGreen) override { return record(DECISION_MOVE, inner->moveOnLight(isGreen)) != 0.0; }
+    bool chooseLeft(int step, int totalSteps) override;
+    void beginTaps() override;
+    bool tap(double tip, double windowL, double windowR) override;
+
+private:
+    double record(DecisionKind kind, double value);
+
+    PlayerController *inner;
+    FILE *out;
+};
+
+// Answers from a journal instead of the console; stops matching (and keeps
+// answering "stay", "right" and "stop") if the games ask for something else
+class ReplayController : public PlayerController
+{
+public:
+    explicit ReplayController(vector<Decision> decisions) : decisions(move(decisions)) {}
+    bool verbose() const override { return true; }
+    double now() override { return next(DECISION_NOW); }
+    bool moveOnLight(bool isGreen) override;
+    bool chooseLeft(int step, int totalSteps) override;
+    void beginTaps() override { next(DECISION_BEGIN_TAPS); }
+    bool tap(double tip, double windowL, double windowR) override;
+    bool matched() const { return !diverged && pos == decisions.size(); }
+    size_t replayed() const { return pos; }
+
+private:
+    double next(DecisionKind kind);
+
+    vector<Decision> decisions;
+    size_t pos = 0;
+    bool diverged = false;
 };
 
 // ===== Out-of-class Definitions =====
 
+PlayerController::~PlayerController() {}
+
+double ConsoleController::now() { return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count(); }
+bool ConsoleController::moveOnLight(bool isGreen)
+{
+    cout << "     Light: " << (isGreen ? "GREEN" : "RED")
+         << " | press 'm' to MOVE or other to stay: ";
+    string s;
+    cin >> s;
+    s = toLower(s);
+    return s == "m" || s == "move";
+}
+bool ConsoleController::chooseLeft(int step, int totalSteps)
+{
+    cout << "     Step " << (step + 1) << "/" << totalSteps << ": choose left/right: ";
+    string choice;
+    cin >> choice;
+    choice = toLower(choice);
+    while (choice != "left" && choice != "right")
+    {
+        cout << "     left/right: ";
+        cin >> choice;
+        choice = toLower(choice);
+    }
+    return choice == "left";
+}
+void ConsoleController::beginTaps()
+{
+    // Consume the trailing newline from previous inputs
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+}
+bool ConsoleController::tap(double tip, double windowL, double windowR)
+{
+    (void)tip, (void)windowL, (void)windowR; // shown after each tap instead
+    cout << "     Tap (ENTER) or 'q'+ENTER to finish: ";
+    string line;
+    getline(cin, line);
+    return !(line == "q" || line == "Q");
+}
+
+bool BotController::moveOnLight(bool isGreen)
+{
+    clock += strategy->reactionSec * (0.5 + rng().unit());
+    bool mistake = rng().unit() < strategy->mistakeRate;
+    return isGreen != mistake;
+}
+bool BotController::chooseLeft(int step, int totalSteps)
+{
+    (void)totalSteps;
+    clock += strategy->reactionSec;
+    switch (strategy->bridge)
+    {
+    case BRIDGE_LEFT:
+        return true;
+    case BRIDGE_ALTERNATE:
+        return step % 2 == 0;
+    default:
+        return rng().coin();
+    }
+}
+bool BotController::tap(double tip, double windowL, double windowR)
+{
+    double interval = (1.0 + strategy->tapJitter * (2.0 * rng().unit() - 1.0)) / strategy->tapHz;
+    if (strategy->tracking && tip > (windowL + windowR) / 2)
+        interval *= 2.5; // let the bar shrink back toward the window
+    clock += interval;
+    return true; // the round ends on its timer
+}
+
+double RecordingController::record(DecisionKind kind, double value)
+{
+    Decision d;
+    d.kind = kind;
+    d.value = value;
+    // One decision per keypress at most; flush so a session cut short is still replayable
+    fwrite(&d, sizeof(d), 1, out);
+    fflush(out);
+    return value;
+}
+bool RecordingController::chooseLeft(int step, int totalSteps)
+{
+    return record(DECISION_CHOOSE_LEFT, inner->chooseLeft(step, totalSteps)) != 0.0;
+}
+void RecordingController::beginTaps()
+{
+    inner->beginTaps();
+    record(DECISION_BEGIN_TAPS, 0.0);
+}
+bool RecordingController::tap(double tip, double windowL, double windowR)
+{
+    return record(DECISION_TAP, inner->tap(tip, windowL, windowR)) != 0.0;
+}
+
+double ReplayController::next(DecisionKind kind)
+{
+    if (diverged || pos == decisions.size() || decisions[pos].kind != kind)
+    {
+        diverged = true;
+        return 0.0;
+    }
+    return decisions[pos++].value;
+}
+bool ReplayController::moveOnLight(bool isGreen)
+{
+    bool move = next(DECISION_MOVE) != 0.0;
+    cout << "     Light: " << (isGreen ? "GREEN" : "RED") << " | " << (move ? "move" : "stay") << "\n";
+    return move;
+}
+bool ReplayController::chooseLeft(int step, int totalSteps)
+{
+    bool left = next(DECISION_CHOOSE_LEFT) != 0.0;
+    cout << "     Step " << (step + 1) << "/" << totalSteps << ": " << (left ? "left" : "right") << "\n";
+    return left;
+}
+bool ReplayController::tap(double tip, double windowL, double windowR)
+{
+    (void)tip, (void)windowL, (void)windowR;
+    return next(DECISION_TAP) != 0.0;
+}
+
+static bool writeSessionHeader(FILE *out, uint64_t seed, const vector<string> &names)
+{
+    SessionHeader header;
+    header.seed = seed;
+    header.tuning = tuning;
+    header.players = (uint32_t)names.size();
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    for (const string &name : names)
+    {
+        uint32_t length = (uint32_t)name.size();
+        ok = ok && fwrite(&length, sizeof(length), 1, out) == 1 && fwrite(name.data(), 1, length, out) == length;
+    }
+    return ok && fflush(out) == 0;
+}
+
+static bool readSession(const string &path, SessionHeader &header, vector<string> &names, vector<Decision> &decisions)
+{
+    FILE *in = fopen(path.c_str(), "rb");
+    if (!in)
+        return false;
+    bool ok = fread(&header, sizeof(header), 1, in) == 1 && memcmp(header.magic, SessionHeader().magic, 8) == 0;
+    for (uint32_t i = 0; ok && i < header.players; ++i)
+    {
+        uint32_t length = 0;
+        ok = fread(&length, sizeof(length), 1, in) == 1 && length <= 4096;
+        string name(ok ? length : 0, '\0');
+        ok = ok && fread(&name[0], 1, length, in) == length;
+        names.push_back(move(name));
+    }
+    Decision d;
+    while (ok && fread(&d, sizeof(d), 1, in) == 1)
+        decisions.push_back(d);
+    fclose(in);
+    return ok;
+}
+
+void PlayerTable::add(string_view playerName, PlayerController *c)
+{
+    nameId.push_back(names.intern(playerName));
+    controller.push_back(c);
+    alive.push(true);
+    rlgAttempts.push_back(0);
+    bridgeStep.push_back(0);
+    tugStrength.push_back(0.0);
+    gamesCleared.push_back(0);
+}
+void PlayerTable::clear()
+{
+    nameId.clear();
+    controller.clear();
+    alive.clear();
+    rlgAttempts.clear();
+    bridgeStep.clear();
+    tugStrength.clear();
+    gamesCleared.clear();
+}
+
 Game::~Game() {}
-void Game::startRound(vector<Player> &players) { (void)players; }
+void Game::startRound(PlayerTable &players) { (void)players; }
 
 const char *RedLightGreenLight::title() const { return "Red Light Green Light"; }
-void RedLightGreenLight::play(Player &p)
+void RedLightGreenLight::play(PlayerTable &players, size_t i)
 {
-    if (!p.alive)
+    if (!players.alive.test(i))
         return;
-    cout << "  -> RLGL for " << p.name << "\n";
-    const int required = 4;      // requires 4 successful GREEN moves
-    const int timeLimitSec = 20; // 20s round budget
-    p.rlgAttempts = 0;
+    PlayerController &c = *players.controller[i];
+    int &attempts = players.rlgAttempts[i];
+    bool alive = true;
+    bool say = c.verbose();
+    if (say)
+        cout << "  -> RLGL for " << players.name(i) << "\n";
+    const int required = tuning.rlglRequired;            // requires 4 successful GREEN moves
+    const double timeLimitSec = tuning.rlglTimeLimitSec; // 20s round budget
+    attempts = 0;
 
-    auto t0 = chrono::steady_clock::now();
+    double t0 = c.now();
     uniform_int_distribution<int> coin(0, 1); // 0=RED, 1=GREEN
-    while (p.alive && p.rlgAttempts < required)
+    while (alive && attempts < required)
     {
-        auto now = chrono::steady_clock::now();
-        int elapsed = (int)chrono::duration_cast<chrono::seconds>(now - t0).count();
-        if (elapsed >= timeLimitSec)
+        if (c.now() - t0 >= timeLimitSec)
         {
-            cout << "     TIMEOUT -> eliminated\n";
-            p.alive = false;
+            if (say)
+                cout << "     TIMEOUT -> eliminated\n";
+            alive = false;
             break;
         }
 
         bool isGreen = coin(rng()) == 1; // 50/50
-        cout << "     Light: " << (isGreen ? "GREEN" : "RED")
-             << " | press 'm' to MOVE or other to stay: ";
-        string s;
-        cin >> s;
-        s = toLower(s);
-        bool move = (s == "m" || s == "move");
+        bool move = c.moveOnLight(isGreen);
 
         if (move && !isGreen)
         {
-            cout << "     Moved on RED -> eliminated\n";
-            p.alive = false;
+            if (say)
+                cout << "     Moved on RED -> eliminated\n";
+            alive = false;
             break;
         }
         if (move && isGreen)
         {
-            p.rlgAttempts++;
-            cout << "     Success " << p.rlgAttempts << "/" << required << "\n";
+            attempts++;
+            if (say)
+                cout << "     Success " << attempts << "/" << required << "\n";
         }
-        else
+        else if (say)
         {
             cout << "     Stayed\n";
         }
     }
-    if (p.alive && p.rlgAttempts >= required)
-    {
+    if (!alive)
+        players.alive.reset(i);
+    else if (say)
         cout << "  -> RLGL complete\n";
-    }
 }
 
 const char *GlassBridge::title() const { return "Glass Bridge"; }
-void GlassBridge::startRound(vector<Player> &players)
+void GlassBridge::startRound(PlayerTable &players)
 {
     // Choose a guaranteed survivor if >=3 alive to ensure progress
-    guaranteedName.clear();
-    vector<string> alive;
-    for (auto &p : players)
-        if (p.alive)
-            alive.push_back(p.name);
-    if (alive.size() >= 3)
+    guaranteed = SIZE_MAX;
+    size_t alive = players.alive.count();
+    if (alive >= 3)
     {
-        uniform_int_distribution<size_t> pick(0, alive.size() - 1);
-        guaranteedName = alive[pick(rng())];
+        uniform_int_distribution<size_t> pick(0, alive - 1);
+        guaranteed = players.alive.nth(pick(rng()));
     }
 }
-void GlassBridge::play(Player &p)
+void GlassBridge::play(PlayerTable &players, size_t i)
 {
-    if (!p.alive)
+    if (!players.alive.test(i))
         return;
-    cout << "  -> Bridge for " << p.name << "\n";
-    p.bridgeStep = 0;
-    const int totalSteps = 5;
-    while (p.alive && p.bridgeStep < totalSteps)
+    PlayerController &c = *players.controller[i];
+    int &bridgeStep = players.bridgeStep[i];
+    bool alive = true;
+    bool say = c.verbose();
+    if (say)
+        cout << "  -> Bridge for " << players.name(i) << "\n";
+    bridgeStep = 0;
+    const int totalSteps = tuning.bridgeSteps;
+    while (alive && bridgeStep < totalSteps)
     {
-        int step = p.bridgeStep;
-        cout << "     Step " << (step + 1) << "/" << totalSteps << ": choose left/right: ";
-        string choice;
-        cin >> choice;
-        choice = toLower(choice);
-        while (choice != "left" && choice != "right")
-        {
-            cout << "     left/right: ";
-            cin >> choice;
-            choice = toLower(choice);
-        }
+        int step = bridgeStep;
+        bool choseLeft = c.chooseLeft(step, totalSteps);
 
         bool survive = false;
-        string correct = choice;
+        bool correctLeft = choseLeft;
 
         if (step == 0)
         {
             // First step always safe
             survive = true;
         }
-        else if (!guaranteedName.empty() && p.name == guaranteedName)
+        else if (i == guaranteed)
         {
             survive = true; // guaranteed path if chosen
         }
@@ -202,175 +553,112 @@ void GlassBridge::play(Player &p)
         {
             // 60% chance the chosen tile is safe
             uniform_real_distribution<double> U(0.0, 1.0);
-            survive = (U(rng()) < 0.60);
+            survive = (U(rng()) < tuning.bridgeSafeChance);
             if (!survive)
-                correct = (choice == "left" ? "right" : "left");
+                correctLeft = !choseLeft;
         }
 
         if (survive)
         {
-            cout << "       Safe step!\n";
-            p.bridgeStep++;
+            if (say)
+                cout << "       Safe step!\n";
+            bridgeStep++;
         }
         else
         {
-            cout << "       Glass broke! Correct was: " << correct << " -> eliminated\n";
-            p.alive = false;
+            if (say)
+                cout << "       Glass broke! Correct was: " << (correctLeft ? "left" : "right") << " -> eliminated\n";
+            alive = false;
         }
     }
-    if (p.alive && p.bridgeStep >= totalSteps)
-    {
+    if (!alive)
+        players.alive.reset(i);
+    else if (say)
         cout << "  -> Crossed the bridge\n";
-    }
 }
 
 const char *TugOfWar::title() const { return "Tug of War"; }
-void TugOfWar::play(Player &p)
+void TugOfWar::play(PlayerTable &players, size_t i)
 {
-    if (!p.alive)
+    if (!players.alive.test(i))
         return;
-    cout << "  -> Tug of War for " << p.name << "\n";
-    cout << "     Timer starts on first tap. Press ENTER repeatedly to tap.\n";
-    cout << "     Type 'q' + ENTER to stop early.\n";
-
-    // Track layout (abstract units)
-    const double trackW = 1000.0;
-    const double targetW = 100.0;
-    double targetX = 18.0; // px from left
-    double targetV = 0.0;  // px/s
-    double targetA = 0.0;  // px/s^2
-    double accelTimer = 0.0;
-    const double minV = 80.0, maxV = 340.0, maxA = 600.0;
-    auto randomizeAccel = [&]()
+    PlayerController &c = *players.controller[i];
+    double &strength = players.tugStrength[i];
+    bool say = c.verbose();
+    if (say)
     {
-        uniform_real_distribution<double> U(-maxA, maxA);
-        uniform_real_distribution<double> T(0.18, 0.78);
-        targetA = U(rng());
-        accelTimer = T(rng());
-    };
-    randomizeAccel();
-
-    // Bar
-    const double barMin = 6.0, barMax = trackW * 0.85;
-    const double shrinkSpeed = 210.0; // px/s
-    const double baseInc = 30.0;      // px per tap
-    double barW = barMin;
-    auto lastTap = chrono::steady_clock::time_point{};
+        cout << "  -> Tug of War for " << players.name(i) << "\n";
+        cout << "     Timer starts on first tap. Press ENTER repeatedly to tap.\n";
+        cout << "     Type 'q' + ENTER to stop early.\n";
+    }
+
+    // Physics live in backend/tug_physics.h so recorded tap timelines can be
+    // replayed (and batch-validated) with exactly the same results
+    TugParams params;
+    params.durationSec = tuning.tugDurationSec;
+    params.gainPerSec = tuning.tugGainPerSec;
+    TugPhysics tug(rng()(), params);
 
     // Timing
-    const double duration = 10.0;
     bool started = false;
-    auto t0 = chrono::steady_clock::time_point{};
-    auto tPrev = chrono::steady_clock::time_point{};
+    double t0 = 0.0;
 
-    p.tugStrength = 0.0;
+    strength = 0.0;
 
-    // Consume the trailing newline from previous inputs
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    c.beginTaps();
 
     while (true)
     {
         // Early end if timer elapsed
-        if (started)
-        {
-            auto now = chrono::steady_clock::now();
-            double t = chrono::duration<double>(now - t0).count();
-            if (t >= duration)
-                break;
-        }
+        if (started && c.now() - t0 >= params.durationSec)
+            break;
 
-        cout << "     Tap (ENTER) or 'q'+ENTER to finish: ";
-        string line;
-        getline(cin, line);
-        if (line == "q" || line == "Q")
+        if (!c.tap(tug.tip(), tug.windowLeft(), tug.windowRight()))
             break;
 
-        auto now = chrono::steady_clock::now();
+        double now = c.now();
         if (!started)
         {
             started = true;
             t0 = now;
-            tPrev = now;
-            lastTap = now;
         }
 
-        // Time step since last interaction
-        double dt = chrono::duration<double>(now - tPrev).count();
-        if (dt > 0.2)
-            dt = 0.2; // clamp for stability
-        tPrev = now;
-
-        // Target random-walk update
-        accelTimer -= dt;
-        if (accelTimer <= 0.0)
-            randomizeAccel();
-        targetV += targetA * dt;
-        if (fabs(targetV) < minV)
-            targetV = (targetV >= 0.0 ? 1.0 : -1.0) * minV;
-        if (targetV > maxV)
-            targetV = maxV;
-        if (targetV < -maxV)
-            targetV = -maxV;
-        targetX += targetV * dt;
-        if (targetX < 2.0)
-        {
-            targetX = 2.0;
-            targetV = fabs(targetV);
-            randomizeAccel();
-        }
-        if (targetX + targetW > trackW - 2.0)
-        {
-            targetX = trackW - 2.0 - targetW;
-            targetV = -fabs(targetV);
-            randomizeAccel();
-        }
+        bool inWindow = tug.tap(now - t0);
+        strength = tug.strength();
 
-        // Passive shrink between taps
-        barW -= shrinkSpeed * dt;
-        if (barW < barMin)
-            barW = barMin;
-
-        // Compute tap growth with frequency-based bonus
-        double dtTap = lastTap.time_since_epoch().count() ? chrono::duration<double>(now - lastTap).count() : 0.35;
-        lastTap = now;
-        double bonus = min(5.0, 0.5 / max(0.04, dtTap));
-        double inc = baseInc * (1.0 + bonus);
-        barW = min(barMax, barW + inc);
-
-        // Score if bar tip inside target window
-        double tip = barW; // bar grows from left=0
-        bool inWindow = (tip >= targetX && tip <= targetX + targetW);
-        if (inWindow)
-        {
-            p.tugStrength += dt * 28.0; // gain per second while aligned
-        }
-
-        cout << "       tip=" << (int)tip << " window=[" << (int)targetX << "," << (int)(targetX + targetW) << "]"
-             << (inWindow ? " GOOD" : " ") << " | strength=" << (int)p.tugStrength << "\n";
+        if (say)
+            cout << "       tip=" << (int)tug.tip() << " window=[" << (int)tug.windowLeft() << ","
+                 << (int)tug.windowRight() << "]" << (inWindow ? " GOOD" : " ") << " | strength=" << (int)strength
+                 << "\n";
     }
 
-    cout << "  -> Tug complete (strength=" << (int)p.tugStrength << ")\n";
+    if (say)
+        cout << "  -> Tug complete (strength=" << (int)strength << ")\n";
 }
 
-void GameManager::addPlayer(const string &name) { players.push_back(Player{name}); }
+void GameManager::addPlayer(string_view name, PlayerController *controller) { players.add(name, controller); }
 void GameManager::addGame(Game *g) { games.push_back(g); }
 void GameManager::run()
 {
     for (size_t gi = 0; gi < games.size(); ++gi)
     {
         Game *g = games[gi];
-        cout << "\n=== " << g->title() << " ===\n";
-        showRulesOnce((int)gi);
+        if (verbose)
+        {
+            cout << "\n=== " << g->title() << " ===\n";
+            showRulesOnce((int)gi);
+        }
         g->startRound(players);
-        for (auto &p : players)
-            if (p.alive)
-                g->play(p);
+        players.alive.forEachSet([&](size_t i) { g->play(players, i); });
 
         // After Tug-of-War (index 2), keep only highest strength
         if (gi == 2)
             applyTugSurvivors();
+
+        players.alive.forEachSet([&](size_t i) { players.gamesCleared[i] = (int)gi + 1; });
     }
-    printResults();
+    if (verbose)
+        printResults();
 }
 void GameManager::showRulesOnce(int gameIndex)
 {
@@ -380,12 +668,13 @@ void GameManager::showRulesOnce(int gameIndex)
     switch (gameIndex)
     {
     case 0:
-        cout << "- Goal: complete 4 GREEN moves within time.\n";
+        cout << "- Goal: complete " << tuning.rlglRequired << " GREEN moves within time.\n";
         cout << "- Moving on RED eliminates you.\n";
         break;
     case 1:
-        cout << "- Goal: make 5 safe choices across the bridge.\n";
-        cout << "- First step is always safe; 50/50 feel, ~60% chosen safe.\n";
+        cout << "- Goal: make " << tuning.bridgeSteps << " safe choices across the bridge.\n";
+        cout << "- First step is always safe; 50/50 feel, ~" << (int)(tuning.bridgeSafeChance * 100)
+             << "% chosen safe.\n";
         break;
     case 2:
         cout << "- Tap to extend; shrink when idle.\n";
@@ -396,35 +685,327 @@ void GameManager::showRulesOnce(int gameIndex)
 }
 void GameManager::applyTugSurvivors()
 {
-    double maxS = -1e9;
-    for (auto &p : players)
-        if (p.alive)
-            maxS = max(maxS, p.tugStrength);
+    double maxS = maxWhereSet(players.alive, players.tugStrength.data());
     if (maxS < 0)
         return;
-    for (auto &p : players)
-        if (p.alive)
-        {
-            if ((int)floor(p.tugStrength) < (int)floor(maxS))
-                p.alive = false; // ties survive
-        }
+    // floor(s) < floor(maxS) exactly when s < floor(maxS), so ties on the
+    // whole-number strength survive
+    clearWhereLess(players.alive, players.tugStrength.data(), floor(maxS));
 }
 void GameManager::printResults()
 {
     cout << "\n=== Final Results ===\n";
-    for (auto &p : players)
+    for (size_t i = 0; i < players.size(); ++i)
     {
-        cout << p.name << " | " << (p.alive ? "SURVIVED" : "ELIMINATED")
-             << " | strength=" << (int)floor(p.tugStrength) << "\n";
+        cout << players.name(i) << " | " << (players.alive.test(i) ? "SURVIVED" : "ELIMINATED")
+             << " | strength=" << (int)floor(players.tugStrength[i]) << "\n";
     }
 }
 
-int main()
+// One record per game each player entered, in the same log the HTTP backend
+// writes, so console games show up on its /leaderboard
+bool GameManager::saveResults(const string &path)
+{
+    ResultsLog log;
+    string error;
+    if (!log.open(path, error))
+    {
+        cerr << "Results not saved: " << error << "\n";
+        return false;
+    }
+    vector<ResultRecord> records;
+    for (size_t i = 0; i < players.size(); ++i)
+    {
+        int cleared = players.gamesCleared[i];
+        records.push_back(makeResult(ResultGame::RedLight, players.name(i), (uint32_t)players.rlgAttempts[i], cleared > 0));
+        if (cleared >= 1)
+            records.push_back(makeResult(ResultGame::GlassBridge, players.name(i), (uint32_t)players.bridgeStep[i], cleared > 1));
+        if (cleared >= 2)
+            records.push_back(makeResult(ResultGame::TugOfWar, players.name(i), (uint32_t)floor(players.tugStrength[i]),
+                                         players.alive.test(i)));
+    }
+    if (!log.append(records.data(), records.size(), error) || !log.sync())
+    {
+        cerr << "Results not saved: " << (error.empty() ? "write failed" : error) << "\n";
+        return false;
+    }
+    return true;
+}
+
+// ===== Headless Simulation =====
+
+struct SimOptions
+{
+    uint64_t tournaments = 0;
+    int playersPerTournament = 4;
+    unsigned threads = 0; // 0 = one per hardware thread
+    uint64_t seed = 0;
+    vector<int> strategies; // indices into STRATEGIES, assigned round-robin to seats
+};
+
+static const int GAME_COUNT = 3;
+
+// Per-worker tallies, merged once at the end
+struct SimTally
+{
+    vector<uint64_t> entered;  // [game * STRATEGY_COUNT + strategy]
+    vector<uint64_t> cleared;  // same layout; Tug of War counts the survivor rule
+    vector<uint64_t> champions; // [strategy] players alive after the last game
+    vector<double> tugStrength; // [strategy] summed over players who reached Tug of War
+    SimTally()
+        : entered(GAME_COUNT * STRATEGY_COUNT), cleared(GAME_COUNT * STRATEGY_COUNT), champions(STRATEGY_COUNT),
+          tugStrength(STRATEGY_COUNT) {}
+};
+
+// Everything one worker reuses from tournament to tournament; the player
+// table keeps its capacity and interned names, so steady state allocates nothing
+struct SimWorker
+{
+    RedLightGreenLight rlgl;
+    GlassBridge bridge;
+    TugOfWar tug;
+    vector<BotController> bots;
+    GameManager gm;
+
+    SimWorker()
+    {
+        gm.setVerbose(false);
+        gm.addGame(&rlgl);
+        gm.addGame(&bridge);
+        gm.addGame(&tug);
+    }
+};
+
+static void runTournament(const SimOptions &opt, uint64_t index, SimTally &tally, SimWorker &w)
+{
+    // One stream per tournament, so results do not depend on which worker ran it
+    seedThreadRng(mixSeed(opt.seed, index));
+
+    w.bots.clear();
+    w.gm.clearPlayers();
+    for (int i = 0; i < opt.playersPerTournament; ++i)
+        w.bots.emplace_back(STRATEGIES[opt.strategies[i % opt.strategies.size()]]);
+    for (int i = 0; i < opt.playersPerTournament; ++i)
+    {
+        char name[24];
+        int len = snprintf(name, sizeof(name), "Bot %d", i + 1);
+        w.gm.addPlayer(string_view(name, (size_t)len), &w.bots[i]);
+    }
+    w.gm.run();
+
+    const PlayerTable &roster = w.gm.roster();
+    for (size_t i = 0; i < roster.size(); ++i)
+    {
+        int s = opt.strategies[i % opt.strategies.size()];
+        int cleared = roster.gamesCleared[i];
+        for (int g = 0; g < GAME_COUNT && g <= cleared; ++g)
+        {
+            tally.entered[g * STRATEGY_COUNT + s]++;
+            if (cleared > g)
+                tally.cleared[g * STRATEGY_COUNT + s]++;
+        }
+        if (cleared >= 2)
+            tally.tugStrength[s] += roster.tugStrength[i];
+        if (roster.alive.test(i))
+            tally.champions[s]++;
+    }
+}
+
+static void runSimulation(SimOptions opt)
+{
+    if (opt.threads == 0)
+        opt.threads = max(1u, thread::hardware_concurrency());
+    if (opt.strategies.empty())
+        for (int s = 0; s < STRATEGY_COUNT; ++s)
+            opt.strategies.push_back(s);
+
+    vector<SimTally> tallies(opt.threads);
+    auto started = chrono::steady_clock::now();
+    parallelFor(opt.tournaments, opt.threads, [&](unsigned worker, size_t index)
+    {
+        thread_local SimWorker state;
+        runTournament(opt, index, tallies[worker], state);
+    });
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    SimTally total;
+    for (auto &t : tallies)
+    {
+        for (size_t i = 0; i < total.entered.size(); ++i)
+        {
+            total.entered[i] += t.entered[i];
+            total.cleared[i] += t.cleared[i];
+        }
+        for (int s = 0; s < STRATEGY_COUNT; ++s)
+        {
+            total.champions[s] += t.champions[s];
+            total.tugStrength[s] += t.tugStrength[s];
+        }
+    }
+
+    cout << "Simulated " << opt.tournaments << " tournaments x " << opt.playersPerTournament << " players on "
+         << opt.threads << " threads in " << seconds << " s (seed " << opt.seed << ")\n";
+    cout << "Survival rate of players entering each game; champion = alive after Tug of War\n\n";
+
+    char line[160];
+    snprintf(line, sizeof(line), "%-10s %9s %9s %9s %10s %10s\n", "strategy", "RLGL", "Bridge", "Tug", "champion",
+             "tug str.");
+    cout << line;
+    auto rate = [](uint64_t part, uint64_t whole) { return whole ? 100.0 * (double)part / (double)whole : 0.0; };
+    uint64_t allEntered[GAME_COUNT] = {}, allCleared[GAME_COUNT] = {}, allChampions = 0, allTug = 0;
+    double allStrength = 0;
+    bool listed[STRATEGY_COUNT] = {};
+    for (int s : opt.strategies)
+    {
+        if (listed[s])
+            continue;
+        listed[s] = true;
+        const uint64_t *entered = &total.entered[0];
+        const uint64_t *cleared = &total.cleared[0];
+        uint64_t tugPlayers = entered[2 * STRATEGY_COUNT + s];
+        snprintf(line, sizeof(line), "%-10s %8.2f%% %8.2f%% %8.2f%% %9.3f%% %10.1f\n", STRATEGIES[s].name,
+                 rate(cleared[s], entered[s]), rate(cleared[STRATEGY_COUNT + s], entered[STRATEGY_COUNT + s]),
+                 rate(cleared[2 * STRATEGY_COUNT + s], tugPlayers), rate(total.champions[s], entered[s]),
+                 tugPlayers ? total.tugStrength[s] / (double)tugPlayers : 0.0);
+        cout << line;
+        for (int g = 0; g < GAME_COUNT; ++g)
+        {
+            allEntered[g] += entered[g * STRATEGY_COUNT + s];
+            allCleared[g] += cleared[g * STRATEGY_COUNT + s];
+        }
+        allChampions += total.champions[s];
+        allTug += tugPlayers;
+        allStrength += total.tugStrength[s];
+    }
+    snprintf(line, sizeof(line), "%-10s %8.2f%% %8.2f%% %8.2f%% %9.3f%% %10.1f\n", "all",
+             rate(allCleared[0], allEntered[0]), rate(allCleared[1], allEntered[1]), rate(allCleared[2], allEntered[2]),
+             rate(allChampions, allEntered[0]), allTug ? allStrength / (double)allTug : 0.0);
+    cout << line;
+}
+
+static bool parseStrategies(const string &list, vector<int> &out)
+{
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t comma = list.find(',', start);
+        string name = list.substr(start, comma == string::npos ? string::npos : comma - start);
+        int found = -1;
+        for (int s = 0; s < STRATEGY_COUNT; ++s)
+            if (name == STRATEGIES[s].name)
+                found = s;
+        if (found < 0)
+            return false;
+        out.push_back(found);
+        if (comma == string::npos)
+            break;
+        start = comma + 1;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
 {
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
 
+    // Usage: main [--seed=N] [--results=PATH] [--journal=PATH]
+    //        main --replay=PATH
+    //        main --simulate=TOURNAMENTS [--players=N] [--threads=N] [--seed=N]
+    //             [--strategies=careful,reckless,slow,tracker] [--rlgl-time=SEC]
+    //             [--bridge-safe=P] [--tug-duration=SEC] [--tug-gain=PER_SEC]
+    SimOptions sim;
+    bool seeded = false;
+#ifdef SQUID_HAVE_MMAP
+    string resultsPath = "results.log"; // empty = do not save
+#else
+    string resultsPath;
+#endif
+    string journalPath, replayPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        string key = arg.substr(0, eq);
+        string value = eq == string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--seed")
+        {
+            sim.seed = stoull(value);
+            seeded = true;
+        }
+        else if (key == "--results")
+            resultsPath = value;
+        else if (key == "--journal")
+            journalPath = value;
+        else if (key == "--replay")
+            replayPath = value;
+        else if (key == "--simulate")
+            sim.tournaments = stoull(value);
+        else if (key == "--players")
+            sim.playersPerTournament = max(1, stoi(value));
+        else if (key == "--threads")
+            sim.threads = (unsigned)max(0, stoi(value));
+        else if (key == "--strategies" && parseStrategies(value, sim.strategies))
+            continue;
+        else if (key == "--rlgl-time")
+            tuning.rlglTimeLimitSec = stod(value);
+        else if (key == "--bridge-safe")
+            tuning.bridgeSafeChance = stod(value);
+        else if (key == "--tug-duration")
+            tuning.tugDurationSec = stod(value);
+        else if (key == "--tug-gain")
+            tuning.tugGainPerSec = stod(value);
+        else
+        {
+            cerr << "Unknown or invalid option: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    if (sim.tournaments > 0)
+    {
+        if (!seeded)
+            sim.seed = freshSeed();
+        runSimulation(sim);
+        return 0;
+    }
     GameManager gm;
+    gm.addGame(new RedLightGreenLight());
+    gm.addGame(new GlassBridge());
+    gm.addGame(new TugOfWar());
+
+    if (!replayPath.empty())
+    {
+        // Same seed, tuning and players, decisions from the journal; nothing is saved
+        SessionHeader header;
+        vector<string> names;
+        vector<Decision> decisions;
+        if (!readSession(replayPath, header, names, decisions))
+        {
+            cerr << "Cannot read session journal " << replayPath << "\n";
+            return 1;
+        }
+        tuning = header.tuning;
+        seedThreadRng(header.seed);
+        ReplayController replay(move(decisions));
+        for (const string &name : names)
+            gm.addPlayer(name, &replay);
+        gm.run();
+        cout << "\nReplayed " << replay.replayed() << " decisions"
+             << (replay.matched() ? "; the session matched its journal\n" : "; the session diverged from its journal\n");
+        return replay.matched() ? 0 : 1;
+    }
+
+    // A journaled session needs a known seed to be replayable
+    if (!journalPath.empty() && !seeded)
+    {
+        sim.seed = freshSeed();
+        seeded = true;
+    }
+    if (seeded)
+        seedThreadRng(sim.seed);
+
+    ConsoleController console;
     // Prompt for players; default 2 if invalid
     int n = 2;
     cout << "Enter number of players (1-10) [default 2]: ";
@@ -433,6 +1014,7 @@ int main()
         cin.clear();
         n = 2;
     }
+    vector<string> names;
     for (int i = 0; i < n; ++i)
     {
         string name;
@@ -441,14 +1023,29 @@ int main()
         getline(cin, name);
         if (name.empty())
             name = string("Player ") + to_string(i + 1);
-        gm.addPlayer(name);
+        names.push_back(name);
     }
 
-    gm.addGame(new RedLightGreenLight());
-    gm.addGame(new GlassBridge());
-    gm.addGame(new TugOfWar());
+    FILE *journal = nullptr;
+    if (!journalPath.empty())
+    {
+        journal = fopen(journalPath.c_str(), "wb");
+        if (!journal || !writeSessionHeader(journal, sim.seed, names))
+        {
+            cerr << "Cannot write session journal " << journalPath << ": " << strerror(errno) << "\n";
+            return 1;
+        }
+    }
+    RecordingController recorder(console, journal);
+    PlayerController *controller = journal ? (PlayerController *)&recorder : &console;
+    for (const string &name : names)
+        gm.addPlayer(name, controller);
 
     gm.run();
+    if (journal)
+        fclose(journal);
+    if (!resultsPath.empty())
+        gm.saveResults(resultsPath);
 
     // Cleanup
     return 0;
@@ -14,8 +14,8 @@ $gppExists = Get-Command g++ -ErrorAction SilentlyContinue
 $clExists = Get-Command cl -ErrorAction SilentlyContinue
 
 if ($gppExists) {
-    Write-Host "Compiling backend.cpp with g++..." -ForegroundColor Yellow
-    g++ backend.cpp -o backend.exe -lws2_32 -std=c++11
+    Write-Host "Compiling backend.cpp and games.cpp with g++..." -ForegroundColor Yellow
+    g++ backend.cpp games.cpp -o backend.exe -lws2_32 -std=c++17
     
     if ($LASTEXITCODE -eq 0) {
         Write-Host "✓ Compilation successful!" -ForegroundColor Green
@@ -32,8 +32,8 @@ if ($gppExists) {
     }
 }
 elseif ($clExists) {
-    Write-Host "Compiling backend.cpp with MSVC (cl)..." -ForegroundColor Yellow
-    cl backend.cpp ws2_32.lib /EHsc
+    Write-Host "Compiling backend.cpp and games.cpp with MSVC (cl)..." -ForegroundColor Yellow
+    cl backend.cpp games.cpp ws2_32.lib /EHsc /std:c++17
     
     if ($LASTEXITCODE -eq 0) {
         Write-Host "✓ Compilation successful!" -ForegroundColor Green